@@ -2,7 +2,29 @@ d=$(dirname $0);
 gcc -o $d/gpsmon.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600  $d/gpsmon.c
 
 gcc -o $d/monitor_ubx.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql -lgps $d/monitor_ubx.c
-gcc -o $d/pgubxgpsmon -pthread $d/gpsmon.o $d/monitor_ubx.o $d/lib/libgpsd.a $d/lib/libgps_static.a -lm -lrt -lncurses -ltinfo -lpq 
+
+gcc -o $d/pgsink.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/pgsink.c
+gcc -o $d/linebuf.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/linebuf.c
+gcc -o $d/emit.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/emit.c
+gcc -o $d/ubxframe.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/ubxframe.c
+gcc -o $d/posstats.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/posstats.c
+gcc -o $d/qgate.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/qgate.c
+gcc -o $d/rollup.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/rollup.c
+gcc -o $d/geo.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/geo.c
+gcc -o $d/metrics.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/metrics.c
+gcc -o $d/ubxlink.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/ubxlink.c
+gcc -o $d/timing.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/timing.c
+gcc -o $d/rfmon.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/rfmon.c
+gcc -o $d/txmon.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/txmon.c
+gcc -o $d/sky.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/sky.c
+gcc -o $d/passes.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/passes.c
+gcc -o $d/gnssid.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql $d/gnssid.c
+gcc -o $d/pgubxgpsmon -pthread $d/gpsmon.o $d/monitor_ubx.o $d/pgsink.o $d/linebuf.o $d/emit.o $d/ubxframe.o $d/posstats.o $d/qgate.o $d/rollup.o $d/geo.o $d/metrics.o $d/ubxlink.o $d/timing.o $d/rfmon.o $d/txmon.o $d/sky.o $d/passes.o $d/gnssid.o $d/lib/libgpsd.a $d/lib/libgps_static.a -lm -lrt -lncurses -ltinfo -lpq 
+gcc -o $d/test/geo_test -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql -I$d $d/test/geo_test.c $d/geo.o $d/lib/libgpsd.a $d/lib/libgps_static.a -lm -lrt
+gcc -o $d/test/linebuf_test -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql -I$d $d/test/linebuf_test.c $d/linebuf.o -lm
+gcc -o $d/test/gpsmon_alloc.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql -DALLOC_COUNT $d/gpsmon.c
+gcc -o $d/test/pgsink_alloc.o -c -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql -DALLOC_COUNT $d/pgsink.c
+gcc -o $d/test/alloc_test -pthread -Wall -Wextra -fexcess-precision=standard -Wcast-align -Wcast-qual -Wimplicit-fallthrough -Wmissing-declarations -Wmissing-prototypes -Wno-missing-field-initializers -Wno-uninitialized -Wpointer-arith -Wreturn-type -Wstrict-prototypes -Wundef -Wvla -O2 -pthread -D_DEFAULT_SOURCE -D_XOPEN_SOURCE=600 -I/usr/include/postgresql -I$d $d/test/alloc_test.c $d/test/gpsmon_alloc.o $d/monitor_ubx.o $d/test/pgsink_alloc.o $d/linebuf.o $d/emit.o $d/ubxframe.o $d/posstats.o $d/qgate.o $d/rollup.o $d/geo.o $d/metrics.o $d/ubxlink.o $d/timing.o $d/rfmon.o $d/txmon.o $d/sky.o $d/passes.o $d/gnssid.o $d/lib/libgpsd.a $d/lib/libgps_static.a -lm -lrt -lncurses -ltinfo -lpq 
 
 
 
@@ -0,0 +1,93 @@
+/*
+ * Length-prefixed binary record stream for downstream tools.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "include/emit.h"
+#include "include/strfuncs.h"
+
+static int emit_fd = -1;
+static bool emit_stdout;        // stdout belongs to the records
+
+/* Parse --emit: "text" (default), "binary" for stdout or
+ * "binary:PATH" for a file or FIFO.  Opening a FIFO waits for
+ * its reader. */
+bool emit_open(const char *spec)
+{
+    if (0 == strcmp(spec, "text")) {
+        return true;
+    }
+    if (0 == strcmp(spec, "binary")) {
+        emit_fd = STDOUT_FILENO;
+        emit_stdout = true;
+    } else if (str_starts_with(spec, "binary:") &&
+               '\0' != spec[7]) {
+        emit_fd = open(spec + 7, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (0 > emit_fd) {
+            (void)fprintf(stderr, "emit: can't open %s: %s\n",
+                          spec + 7, strerror(errno));
+            return false;
+        }
+    } else {
+        return false;
+    }
+    // a vanished reader shows up as EPIPE, not as a fatal signal
+    (void)signal(SIGPIPE, SIG_IGN);
+    return true;
+}
+
+bool emit_binary(void)
+{
+    return 0 <= emit_fd;
+}
+
+// true while the console text may go to stdout
+bool emit_text(void)
+{
+    return !emit_stdout;
+}
+
+void emit_record(struct emit_hdr_t *hdr, uint8_t type, size_t len)
+{
+    const char *p = (const char *)hdr;
+
+    if (0 > emit_fd) {
+        return;
+    }
+    hdr->len = (uint16_t)len;
+    hdr->type = type;
+    hdr->version = EMIT_VERSION;
+    while (0 < len) {
+        ssize_t st = write(emit_fd, p, len);
+
+        if (0 > st &&
+            EINTR == errno) {
+            continue;
+        }
+        if (0 >= st) {
+            (void)fprintf(stderr, "emit: stream closed: %s\n",
+                          strerror(errno));
+            if (STDOUT_FILENO != emit_fd) {
+                (void)close(emit_fd);
+            }
+            emit_fd = -1;
+            return;
+        }
+        p += st;
+        len -= (size_t)st;
+    }
+}
+
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,172 @@
+/*
+ * WGS 84 ECEF, geodetic and local east/north/up conversions.
+ *
+ * ECEF to geodetic is Vermeille's closed form (J. Geodesy 2004): no
+ * iteration and no data dependent branches, one cbrt(), four sqrt(),
+ * one atan() and one atan2() per point, exact to well under a micrometre for any
+ * point outside the few hundred kilometres around the Earth's centre.
+ * The *_n() entry points run the same arithmetic over arrays with
+ * restrict qualified pointers so the compiler may vectorize them.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "include/geo.h"
+#include "include/gps.h"              // for WGS84A, WGS84E, DEG_2_RAD
+
+static inline void ecef_to_llh(double x, double y, double z,
+                               double *lat, double *lon, double *h)
+{
+    const double e4 = WGS84E * WGS84E;
+    double rho2 = x * x + y * y;
+    double rho = sqrt(rho2);
+    double p = rho2 / (WGS84A * WGS84A);
+    double q = (1.0 - WGS84E) / (WGS84A * WGS84A) * z * z;
+    double r = (p + q - e4) / 6.0;
+    double s = e4 * p * q / (4.0 * r * r * r);
+    double t = cbrt(1.0 + s + sqrt(s * (2.0 + s)));
+    double u = r * (1.0 + t + 1.0 / t);
+    double v = sqrt(u * u + e4 * q);
+    double w = WGS84E * (u + v - q) / (2.0 * v);
+    double k = sqrt(u + v + w * w) - w;
+    double d = k * rho / (k + WGS84E);
+    double dz = sqrt(d * d + z * z);
+
+    // d + dz > 0, so atan() does what atan2() would, cheaper
+    *lat = 2.0 * atan(z / (d + dz)) * RAD_2_DEG;
+    *lon = atan2(y, x) * RAD_2_DEG;
+    *h = (k + WGS84E - 1.0) / k * dz;
+}
+
+// ECEF (m) to latitude, longitude (degrees) and height above ellipsoid (m)
+void geo_ecef_to_llh(double x, double y, double z,
+                     double *lat, double *lon, double *h)
+{
+    ecef_to_llh(x, y, z, lat, lon, h);
+}
+
+void geo_ecef_to_llh_n(const double *restrict x, const double *restrict y,
+                       const double *restrict z, double *restrict lat,
+                       double *restrict lon, double *restrict h, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        ecef_to_llh(x[i], y[i], z[i], &lat[i], &lon[i], &h[i]);
+    }
+}
+
+void geo_llh_to_ecef(double lat, double lon, double h, double ecef[3])
+{
+    double sp = sin(lat * DEG_2_RAD), cp = cos(lat * DEG_2_RAD);
+    double sl = sin(lon * DEG_2_RAD), cl = cos(lon * DEG_2_RAD);
+    double n = WGS84A / sqrt(1.0 - WGS84E * sp * sp);
+
+    ecef[0] = (n + h) * cp * cl;
+    ecef[1] = (n + h) * cp * sl;
+    ecef[2] = (n * (1.0 - WGS84E) + h) * sp;
+}
+
+// tangent frame with origin at lat, lon (degrees), h (m)
+void geo_enu_init(struct geo_enu_t *enu, double lat, double lon, double h)
+{
+    double sp = sin(lat * DEG_2_RAD), cp = cos(lat * DEG_2_RAD);
+    double sl = sin(lon * DEG_2_RAD), cl = cos(lon * DEG_2_RAD);
+
+    geo_llh_to_ecef(lat, lon, h, enu->ref);
+    enu->r[0][0] = -sl;
+    enu->r[0][1] = cl;
+    enu->r[0][2] = 0.0;
+    enu->r[1][0] = -sp * cl;
+    enu->r[1][1] = -sp * sl;
+    enu->r[1][2] = cp;
+    enu->r[2][0] = cp * cl;
+    enu->r[2][1] = cp * sl;
+    enu->r[2][2] = sp;
+}
+
+/* Tangent frame from "LAT,LON,H" (degrees, degrees, m above the
+ * ellipsoid) or "ecef:X,Y,Z" (m). */
+bool geo_enu_parse(struct geo_enu_t *enu, const char *spec)
+{
+    double a, b, c;
+    char tail;
+
+    if (0 == strncmp(spec, "ecef:", 5)) {
+        if (3 != sscanf(spec + 5, "%lf,%lf,%lf%c", &a, &b, &c, &tail)) {
+            return false;
+        }
+        {
+            double lat, lon, h;
+
+            geo_ecef_to_llh(a, b, c, &lat, &lon, &h);
+            geo_enu_init(enu, lat, lon, h);
+        }
+        // keep the given origin exactly, not its round trip
+        enu->ref[0] = a;
+        enu->ref[1] = b;
+        enu->ref[2] = c;
+        return true;
+    }
+    if (3 != sscanf(spec, "%lf,%lf,%lf%c", &a, &b, &c, &tail) ||
+        90.0 < fabs(a) ||
+        180.0 < fabs(b)) {
+        return false;
+    }
+    geo_enu_init(enu, a, b, c);
+    return true;
+}
+
+// offset of an ECEF position from the origin, m east, north, up
+void geo_enu(const struct geo_enu_t *enu, const double ecef[3],
+             double out[3])
+{
+    const double d[3] = {
+        ecef[0] - enu->ref[0],
+        ecef[1] - enu->ref[1],
+        ecef[2] - enu->ref[2],
+    };
+
+    geo_enu_rotate(enu, d, out);
+}
+
+// ECEF vector (a velocity, a difference) into east, north, up
+void geo_enu_rotate(const struct geo_enu_t *enu, const double v[3],
+                    double out[3])
+{
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        out[i] = enu->r[i][0] * v[0] + enu->r[i][1] * v[1] +
+                 enu->r[i][2] * v[2];
+    }
+}
+
+void geo_enu_n(const struct geo_enu_t *enu, const double *restrict x,
+               const double *restrict y, const double *restrict z,
+               double *restrict e, double *restrict n, double *restrict u,
+               size_t count)
+{
+    const double (*r)[3] = enu->r;
+    double x0 = enu->ref[0], y0 = enu->ref[1], z0 = enu->ref[2];
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        double dx = x[i] - x0, dy = y[i] - y0, dz = z[i] - z0;
+
+        e[i] = r[0][0] * dx + r[0][1] * dy;
+        n[i] = r[1][0] * dx + r[1][1] * dy + r[1][2] * dz;
+        u[i] = r[2][0] * dx + r[2][1] * dy + r[2][2] * dz;
+    }
+}
+
+// vim: set expandtab shiftwidth=4
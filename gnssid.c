@@ -0,0 +1,106 @@
+/*
+ * Satellite numbering: the gnssId/svId pair of NAV-SAT and later
+ * messages against the single PRN number of NAV-SVINFO.
+ *
+ * The numbering is spelled out in two constant tables, a PRN per
+ * gnssId and svId and a gnssId and svId per PRN, so each lookup is a
+ * single index whichever the direction.  Pairs without a PRN, such as
+ * NavIC, give 0.  PRN 255 is the GLONASS satellite of unknown slot;
+ * only the pair tells which.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "include/gnssid.h"
+
+// PRN of each gnssId and svId, 0 for none
+static const uint8_t to_prn[GNSSID_N][256] = {
+    // GPS
+    [0] = {[1] = 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+        18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32},
+    // SBAS
+    [1] = {[120] = 120, 121, 122, 123, 124, 125, 126, 127, 128, 129, 130,
+        131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141, 142, 143, 144,
+        145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156, 157, 158},
+    // Galileo
+    [2] = {[1] = 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222,
+        223, 224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236,
+        237, 238, 239, 240, 241, 242, 243, 244, 245, 246},
+    // BeiDou
+    [3] = {[1] = 159, 160, 161, 162, 163, 33, 34, 35, 36, 37, 38, 39, 40, 41,
+        42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58,
+        59, 60, 61, 62, 63, 64},
+    // IMES
+    [4] = {[1] = 173, 174, 175, 176, 177, 178, 179, 180, 181, 182},
+    // QZSS
+    [5] = {[1] = 193, 194, 195, 196, 197, 198, 199, 200, 201, 202},
+    // GLONASS
+    [6] = {[1] = 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79,
+        80, 81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 96,
+        [255] = 255},
+};
+
+// gnssId and svId of each PRN, svId 0 for none
+static const struct {
+    uint8_t gnss, sv;
+} to_native[256] = {
+    [1] = {0, 1}, {0, 2}, {0, 3}, {0, 4}, {0, 5}, {0, 6}, {0, 7}, {0, 8},
+    {0, 9}, {0, 10}, {0, 11}, {0, 12}, {0, 13}, {0, 14}, {0, 15}, {0, 16},
+    {0, 17}, {0, 18}, {0, 19}, {0, 20}, {0, 21}, {0, 22}, {0, 23}, {0, 24},
+    {0, 25}, {0, 26}, {0, 27}, {0, 28}, {0, 29}, {0, 30}, {0, 31}, {0, 32},
+    [33] = {3, 6}, {3, 7}, {3, 8}, {3, 9}, {3, 10}, {3, 11}, {3, 12}, {3, 13},
+    {3, 14}, {3, 15}, {3, 16}, {3, 17}, {3, 18}, {3, 19}, {3, 20}, {3, 21},
+    {3, 22}, {3, 23}, {3, 24}, {3, 25}, {3, 26}, {3, 27}, {3, 28}, {3, 29},
+    {3, 30}, {3, 31}, {3, 32}, {3, 33}, {3, 34}, {3, 35}, {3, 36}, {3, 37},
+    [65] = {6, 1}, {6, 2}, {6, 3}, {6, 4}, {6, 5}, {6, 6}, {6, 7}, {6, 8},
+    {6, 9}, {6, 10}, {6, 11}, {6, 12}, {6, 13}, {6, 14}, {6, 15}, {6, 16},
+    {6, 17}, {6, 18}, {6, 19}, {6, 20}, {6, 21}, {6, 22}, {6, 23}, {6, 24},
+    {6, 25}, {6, 26}, {6, 27}, {6, 28}, {6, 29}, {6, 30}, {6, 31}, {6, 32},
+    [120] = {1, 120}, {1, 121}, {1, 122}, {1, 123}, {1, 124}, {1, 125},
+    {1, 126}, {1, 127}, {1, 128}, {1, 129}, {1, 130}, {1, 131}, {1, 132},
+    {1, 133}, {1, 134}, {1, 135}, {1, 136}, {1, 137}, {1, 138}, {1, 139},
+    {1, 140}, {1, 141}, {1, 142}, {1, 143}, {1, 144}, {1, 145}, {1, 146},
+    {1, 147}, {1, 148}, {1, 149}, {1, 150}, {1, 151}, {1, 152}, {1, 153},
+    {1, 154}, {1, 155}, {1, 156}, {1, 157}, {1, 158},
+    [159] = {3, 1}, {3, 2}, {3, 3}, {3, 4}, {3, 5},
+    [173] = {4, 1}, {4, 2}, {4, 3}, {4, 4}, {4, 5}, {4, 6}, {4, 7}, {4, 8},
+    {4, 9}, {4, 10},
+    [193] = {5, 1}, {5, 2}, {5, 3}, {5, 4}, {5, 5}, {5, 6}, {5, 7}, {5, 8},
+    {5, 9}, {5, 10},
+    [211] = {2, 1}, {2, 2}, {2, 3}, {2, 4}, {2, 5}, {2, 6}, {2, 7}, {2, 8},
+    {2, 9}, {2, 10}, {2, 11}, {2, 12}, {2, 13}, {2, 14}, {2, 15}, {2, 16},
+    {2, 17}, {2, 18}, {2, 19}, {2, 20}, {2, 21}, {2, 22}, {2, 23}, {2, 24},
+    {2, 25}, {2, 26}, {2, 27}, {2, 28}, {2, 29}, {2, 30}, {2, 31}, {2, 32},
+    {2, 33}, {2, 34}, {2, 35}, {2, 36},
+    [255] = {6, 255},
+};
+
+// NAV-SVINFO PRN of gnssId and svId, 0 for none
+unsigned gnssid_prn(unsigned gnss, unsigned sv)
+{
+    if (GNSSID_N <= gnss ||
+        255 < sv) {
+        return 0;
+    }
+    return to_prn[gnss][sv];
+}
+
+// gnssId and svId of a NAV-SVINFO PRN, false for none
+bool gnssid_native(unsigned prn, unsigned *gnss, unsigned *sv)
+{
+    if (255 < prn ||
+        0 == to_native[prn].sv) {
+        return false;
+    }
+    *gnss = to_native[prn].gnss;
+    *sv = to_native[prn].sv;
+    return true;
+}
+
+// vim: set expandtab shiftwidth=4
@@ -34,9 +34,18 @@
 #include "include/gpsdclient.h"
 #include "include/gpsd.h"
 #include "include/gps_json.h"
+#include "include/emit.h"
 #include "include/gpsmon.h"
+#include "include/metrics.h"
+#include "include/pgsink.h"
+#include "include/qgate.h"
+#include "include/rfmon.h"
+#include "include/sky.h"
 #include "include/strfuncs.h"
 #include "include/timespec.h"
+#include "include/txmon.h"
+#include "include/ubxframe.h"
+#include "include/ubxlink.h"
 
 #define BUFLEN          2048
 
@@ -53,9 +62,23 @@ extern const struct gps_type_t driver_nmea0183;
 struct gps_device_t session;
 WINDOW *devicewin;
 bool serial;
+int verbosity = VERB_QUIET;
 
 // These are private
 static volatile int bailout = 0;
+static bool ubxonly = false;            // -u, frame with ubxframe.c
+/* Every buffer of the decode and output path is static, so after the
+ * first HEAP_WARMUP packets nothing calls the heap.  test/alloc_test.c
+ * checks it: it builds this file with ALLOC_COUNT, supplies a malloc()
+ * counting its calls and its own main(), and replays epochs through
+ * gpsmon_replay(). */
+#ifdef ALLOC_COUNT
+#define HEAP_WARMUP     600
+#pragma weak main                       // the test's main() wins
+extern unsigned long alloc_calls(void);
+static unsigned long packets, heap_base;
+#endif
+static struct ubxlex_t ubxlex;
 static struct gps_context_t context;
 static bool curses_active;
 static WINDOW *statwin, *cmdwin;
@@ -136,41 +159,56 @@ static inline void report_unlock(void)
 static void cond_hexdump(char *buf2, size_t len2,
                          const char *buf, size_t len)
 {
-    size_t i;
+    static const char hexchars[] = "0123456789abcdef";
+    size_t i, j;
     bool printable = true;
-    for (i = 0; i < len; i++)
+
+    if (0 == len2) {
+        return;
+    }
+    for (i = 0; i < len; i++) {
         if (!isprint((unsigned char)buf[i]) &&
             !isspace((unsigned char) buf[i])) {
             printable = false;
+            break;
         }
+    }
     if (printable) {
-        size_t j;
         for (i = j = 0; i < len && j < len2 - 1; i++) {
-            if (isprint((unsigned char)buf[i])) {
-                buf2[j++] = buf[i];
-                buf2[j] = '\0';
-            } else {
-                if (TEXTUAL_PACKET_TYPE(session.lexer.type)) {
-                    if (i == len - 1 &&
-                        '\n' == buf[i]) {
-                        continue;
-                    }
-                    if (i == len - 2 &&
-                        '\r' == buf[i]) {
-                        continue;
-                    }
+            unsigned char c = (unsigned char)buf[i];
+
+            if (isprint(c)) {
+                buf2[j++] = (char)c;
+                continue;
+            }
+            if (TEXTUAL_PACKET_TYPE(session.lexer.type)) {
+                if (i == len - 1 &&
+                    '\n' == c) {
+                    continue;
+                }
+                if (i == len - 2 &&
+                    '\r' == c) {
+                    continue;
                 }
-                (void)snprintf(&buf2[j], len2 - strnlen(buf2, len2), "\\x%02x",
-                               (unsigned int)(buf[i] & 0xff));
-                j = strnlen(buf2, len2);
             }
+            if (j + 4 >= len2) {
+                break;
+            }
+            buf2[j++] = '\\';
+            buf2[j++] = 'x';
+            buf2[j++] = hexchars[c >> 4];
+            buf2[j++] = hexchars[c & 0x0f];
         }
     } else {
-        buf2[0] = '\0';
-        for (i = 0; i < len; i++) {
-            str_appendf(buf2, len2, "%02x", (unsigned int)(buf[i] & 0xff));
+        // two table lookups per byte, no formatting
+        for (i = j = 0; i < len && j + 2 < len2; i++) {
+            unsigned char c = (unsigned char)buf[i];
+
+            buf2[j++] = hexchars[c >> 4];
+            buf2[j++] = hexchars[c & 0x0f];
         }
     }
+    buf2[j] = '\0';
 }
 
 void toff_update(WINDOW *win, int y, int x)
@@ -296,8 +334,9 @@ static void monitor_dump_send(const char *buf, size_t len)
 static void gpsmon_report(const char *buf)
 {
     // report locking is left to caller
-   
+    if (emit_text()) {
         (void)fputs(buf, stdout);
+    }
 
     if (NULL != logfile) {
         (void)fputs(buf, logfile);
@@ -658,7 +697,9 @@ bool monitor_control_send( unsigned char *buf, size_t len)
 {
     ssize_t st;
 
-    if (!serial) {
+    if (!serial ||
+        NULL == session.device_type ||
+        NULL == session.device_type->control_send) {
         return false;
     }
 
@@ -696,11 +737,52 @@ static void complain(const char *fmt, ...)
  *
  *****************************************************************************/
 
+// false if the heap was called after the warmup, or it was not reached
+static bool heap_report(void)
+{
+#ifdef ALLOC_COUNT
+    unsigned long calls = alloc_calls() - heap_base;
+
+    if (HEAP_WARMUP >= packets) {
+        (void)fprintf(stderr, "gpsmon: %lu packets, %d needed to count "
+                      "heap calls\n", packets, HEAP_WARMUP);
+        return false;
+    }
+    (void)fprintf(stderr, "gpsmon: %lu heap calls in the %lu packets "
+                  "after the first %d\n", calls, packets - HEAP_WARMUP,
+                  HEAP_WARMUP);
+    return 0 == calls;
+#else
+    return true;
+#endif
+}
+
+// -j: straight from the MON-RF/MON-HW decoder, not through the database
+static void jamming_alert(unsigned block, int jam, bool jammed)
+{
+    if (jammed) {
+        complain("RF block %u: jamming indicator %d, jammed", block, jam);
+    } else {
+        complain("RF block %u: jamming indicator %d, clear", block, jam);
+    }
+}
+
 // per-packet hook
 static void gpsmon_hook(struct gps_device_t *device, gps_mask_t changed UNUSED)
 {
     char buf[BUFSIZ];
 
+#ifdef ALLOC_COUNT
+    if (HEAP_WARMUP == packets) {
+        heap_base = alloc_calls();
+    }
+    packets++;
+#endif
+    if (UBX_PACKET == device->lexer.type &&
+        4 <= device->lexer.outbuflen) {
+        metrics_packet(device->lexer.outbuffer[2]);
+    }
+
 // FIXME:  If the following condition is false, the display is screwed up.
 #if defined(SOCKET_EXPORT_ENABLE) && defined(PPS_DISPLAY_ENABLE)
     char ts_buf1[TIMESPEC_LEN];
@@ -793,23 +875,36 @@ static void gpsmon_hook(struct gps_device_t *device, gps_mask_t changed UNUSED)
 
         if (curses_active) {
             select_packet_monitor(device);
+        } else if (UBX_PACKET == device->lexer.type &&
+                   0 < device->lexer.outbuflen) {
+            // no windows to switch, but still decode and store
+            ubx_mmt.update();
         }
 
-        (void)snprintf(buf, sizeof(buf), "(%d) ",
-                       (int)device->lexer.outbuflen);
-        blen  = strnlen(buf, sizeof(buf));
-        cond_hexdump(buf + blen, sizeof(buf) - blen,
-                     (char *)device->lexer.outbuffer,
-                     device->lexer.outbuflen);
-        (void)strlcat(buf, "\n", sizeof(buf));
+        // the packet window always shows the dump, the console on -vvv
+        buf[0] = '\0';
+        if (curses_active ||
+            VERB_PACKETS <= verbosity) {
+            (void)snprintf(buf, sizeof(buf), "(%d) ",
+                           (int)device->lexer.outbuflen);
+            blen  = strnlen(buf, sizeof(buf));
+            cond_hexdump(buf + blen, sizeof(buf) - blen,
+                         (char *)device->lexer.outbuffer,
+                         device->lexer.outbuflen);
+            (void)strlcat(buf, "\n", sizeof(buf));
+        }
     }
 
     report_lock();
 
     if (!curses_active) {
-        (void)fputs(buf, stdout);
+        // with binary records on stdout the dump must not land among them
+        if ('\0' != buf[0]) {
+            (void)fputs(buf, emit_text() ? stdout : stderr);
+        }
     } else {
-        if (NULL != packetwin) {
+        if (NULL != packetwin &&
+            '\0' != buf[0]) {
             (void)waddstr(packetwin, buf);
             (void)wnoutrefresh(packetwin);
         }
@@ -1142,28 +1237,173 @@ static void onsig(int sig UNUSED) {
 // this placement avoids a compiler warning
 static const char *cmdline;
 
+// hand a frame from ubxframe.c on as if the gpsd lexer had found it
+static void ubx_frame_hook(const unsigned char *frame, size_t len,
+                           void *arg UNUSED)
+{
+    memcpy(session.lexer.outbuffer, frame, len);
+    session.lexer.outbuflen = len;
+    session.lexer.type = UBX_PACKET;
+    gpsmon_hook(&session, 0);
+}
+
+/* Stand-in for gpsd_multipoll() with -u: read whatever the device has
+ * and frame it with the UBX-only lexer. */
+static int ubxonly_poll(bool readable)
+{
+    static unsigned char frame[UBX_FRAME_MAX];
+    static unsigned char in[4096];
+    ssize_t got;
+
+    if (NULL == ubxlex.frame) {
+        ubxlex_init(&ubxlex, frame);
+    }
+    if (!readable) {
+        return DEVICE_UNCHANGED;
+    }
+    got = read(session.gpsdata.gps_fd, in, sizeof(in));
+    if (0 < got) {
+        // what the gpsd lexer would stamp, one vDSO call per read
+        (void)clock_gettime(CLOCK_REALTIME, &session.lexer.pkt_time);
+        metrics_add(M_BYTES, (unsigned long)got);
+        ubxlex_feed(&ubxlex, in, (size_t)got, ubx_frame_hook, NULL);
+        metrics_set(M_BADSUM, ubxlex.st.badsum);
+        return DEVICE_READY;
+    }
+    if (0 == got) {
+        return DEVICE_EOF;
+    }
+    if (EAGAIN == errno ||
+        EINTR == errno) {
+        return DEVICE_UNCHANGED;
+    }
+    return DEVICE_ERROR;
+}
+
+/* Decode a file (or FIFO, or "-" for stdin) of raw UBX through
+ * ubx_scan() instead of the generic lexer, then report the counts. */
+static int replay_ubx(const char *path)
+{
+    static unsigned char buf[1 << 20];
+    struct ubxscan_t st;
+    size_t have = 0;
+    int fd = 0;
+
+    if (0 != strcmp(path, "-")) {
+        fd = open(path, O_RDONLY);
+        if (0 > fd) {
+            (void)fprintf(stderr, "gpsmon: can't open %s: %s\n",
+                          path, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+    memset(&st, 0, sizeof(st));
+    for (;;) {
+        ssize_t got = read(fd, buf + have, sizeof(buf) - have);
+        size_t used;
+
+        if (0 > got &&
+            EINTR == errno) {
+            continue;
+        }
+        if (0 >= got) {
+            break;
+        }
+        have += (size_t)got;
+        metrics_add(M_BYTES, (unsigned long)got);
+        used = ubx_scan(&st, buf, have, ubx_frame_hook, NULL);
+        metrics_set(M_BADSUM, st.badsum);
+        // keep the partial frame at the tail for the next read
+        have -= used;
+        (void)memmove(buf, buf + used, have);
+    }
+    if (0 != fd) {
+        (void)close(fd);
+    }
+    (void)fprintf(stderr, "gpsmon: %lu frames, %lu bad checksums, "
+                  "%lu bytes skipped\n",
+                  st.frames, st.badsum, st.skipped + have);
+    return EXIT_SUCCESS;
+}
+
+/* -r: decode a capture into the database and metrics opened before,
+ * then close both */
+int gpsmon_replay(const char *path)
+{
+    int status;
+
+    gpsd_time_init(&context, time(NULL));
+    gpsd_init(&session, &context, NULL);
+    status = replay_ubx(path);
+    if (!heap_report()) {
+        status = EXIT_FAILURE;
+    }
+    pgsink_close();
+    metrics_close();
+    return status;
+}
+
 static void usage(void)
 {
     (void)fputs(
          "usage: gpsmon [OPTIONS] [server[:port:[device]]]\n\n"
 #ifdef HAVE_GETOPT_LONG
+         "  --baud BAUD         Raise the receiver UART to at most BAUD,\n"
+         "                      UBX only\n"
+         "  --configure MS      Program the UBX output profile and a\n"
+         "                      measurement period of MS ms\n"
          "  --debug DEBUGLEVEL  Set DEBUGLEVEL\n"
+         "  --emit MODE         text, binary (records to stdout) or\n"
+         "                      binary:PATH (records to file or FIFO)\n"
+         "  --freshness MS      Store each row within MS ms\n"
          "  --help              Show this help, then exit\n"
+         "  --jamming LEVEL     Warn when the jamming indicator reaches\n"
+         "                      LEVEL (1-255)\n"
          "  --list              List known device types, then exit.\n"
          "  --logfile FILE      Log to LOGFILE\n"
          "  --nocurses          No curses. Data only.\n"
+         "  --metrics FILE      Write counters to FILE every 10 s\n"
          "  --nmea              Force NMEA mode.\n"
+         "  --overload SEC      Poll the receiver TX buffer every SEC s,\n"
+         "                      report the bottleneck\n"
+         "  --pgconn CONNINFO   Store fixes in PostgreSQL at CONNINFO\n"
+         "  --quality SPEC      Store only fixes passing SPEC, e.g.\n"
+         "                      fix=3,sats=6,pdop=3,acc=5,mad=5,win=31\n"
+         "  --reference POINT   Store offsets from POINT, LAT,LON,H\n"
+         "                      or ecef:X,Y,Z\n"
+         "  --replay FILE       Decode raw UBX from FILE (- for stdin), "
+         "then exit\n"
+         "  --series NAME       Name of the measurement series\n"
+         "  --sky               Also store every NAV-SAT epoch\n"
          "  --type TYPE         Set receiver TYPE\n"
+         "  --ubxonly           Frame UBX only, with the slim lexer\n"
+         "  --verbose           More console output, repeat for more\n"
          "  --version           Show version, then exit\n"
 #endif
          "  -a                  No curses. Data only.\n"
          "  -?                  Show this help, then exit\n"
+         "  -b BAUD             Raise the receiver UART to at most BAUD\n"
+         "  -c MS               Program the UBX output profile\n"
          "  -D DEBUGLEVEL       Set DEBUGLEVEL\n"
+         "  -e MODE             text, binary or binary:PATH\n"
+         "  -F MS               Store each row within MS ms\n"
          "  -h                  Show this help, then exit\n"
+         "  -j LEVEL            Warn at jamming indicator LEVEL\n"
          "  -L                  List known device types, then exit.\n"
          "  -l FILE             Log to LOGFILE\n"
+         "  -m FILE             Write counters to FILE every 10 s\n"
          "  -n                  Force NMEA mode.\n"
+         "  -o SEC              Poll the receiver TX buffer every SEC s\n"
+         "  -p CONNINFO         Store fixes in PostgreSQL at CONNINFO\n"
+         "  -q SPEC             Store only fixes passing SPEC\n"
+         "  -R POINT            Store offsets from POINT\n"
+         "  -r FILE             Decode raw UBX from FILE, then exit\n"
+         "  -s NAME             Name of the measurement series\n"
+         "  -S                  Also store every NAV-SAT epoch\n"
          "  -t TYPE             Set receiver TYPE\n"
+         "  -u                  Frame UBX only, with the slim lexer\n"
+         "  -v                  More console output: 1 fixes, 2 stored rows,\n"
+         "                      3 packet dumps\n"
          "  -V                  Show version, then exit\n",
          stderr);
 }
@@ -1180,17 +1420,35 @@ int main(int argc, char **argv)
     char inbuf[80];
     volatile bool nocurses = false;
     int activated = -1;
-    const char *optstring = "?aD:hLl:nt:V";
+    const char *conninfo = NULL;
+    const char *seriesname = "?";
+    const char *replay = NULL;
+    const char *optstring = "?ab:c:D:e:F:hj:Ll:m:no:p:q:R:r:s:St:uvV";
 #ifdef HAVE_GETOPT_LONG
     int option_index = 0;
     static struct option long_options[] = {
+        {"baud", required_argument, NULL, 'b'},
+        {"configure", required_argument, NULL, 'c'},
         {"debug", required_argument, NULL, 'D'},
+        {"emit", required_argument, NULL, 'e'},
+        {"freshness", required_argument, NULL, 'F'},
         {"help", no_argument, NULL, 'h'},
+        {"jamming", required_argument, NULL, 'j'},
         {"list", no_argument, NULL, 'L' },
         {"logfile", required_argument, NULL, 'l'},
+        {"metrics", required_argument, NULL, 'm'},
         {"nmea", no_argument, NULL, 'n' },
         {"nocurses", no_argument, NULL, 'a' },
+        {"overload", required_argument, NULL, 'o'},
+        {"pgconn", required_argument, NULL, 'p'},
+        {"quality", required_argument, NULL, 'q'},
+        {"reference", required_argument, NULL, 'R'},
+        {"replay", required_argument, NULL, 'r'},
+        {"series", required_argument, NULL, 's'},
+        {"sky", no_argument, NULL, 'S'},
         {"type", required_argument, NULL, 't'},
+        {"ubxonly", no_argument, NULL, 'u'},
+        {"verbose", no_argument, NULL, 'v'},
         {"version", no_argument, NULL, 'V' },
         {NULL, 0, NULL, 0},
     };
@@ -1216,10 +1474,57 @@ int main(int argc, char **argv)
         case 'a':
             nocurses = true;
             break;
+        case 'b':
+            if (!ubxlink_config(optarg)) {
+                (void)fprintf(stderr, "gpsmon: unsupported rate %s\n",
+                              optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'c':
+            if (!ubx_profile(optarg)) {
+                (void)fprintf(stderr, "gpsmon: bad measurement period %s\n",
+                              optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
         case 'D':
             context.errout.debug = atoi(optarg);
             json_enable_debug(context.errout.debug - 2, stderr);
             break;
+        case 'e':
+            if (!emit_open(optarg)) {
+                (void)fprintf(stderr, "Unknown --emit mode %s.\n", optarg);
+                exit(EXIT_FAILURE);
+            }
+            if (!emit_text()) {
+                // records own stdout, curses would scribble on them
+                nocurses = true;
+            }
+            break;
+        case 'F':
+            if (!pgsink_freshness(optarg)) {
+                (void)fprintf(stderr, "gpsmon: bad freshness bound %s\n",
+                              optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'j':
+            {
+                char *end;
+                long level = strtol(optarg, &end, 10);
+
+                if (end == optarg ||
+                    '\0' != *end ||
+                    1 > level ||
+                    255 < level) {
+                    (void)fprintf(stderr, "gpsmon: bad jamming level %s\n",
+                                  optarg);
+                    exit(EXIT_FAILURE);
+                }
+                rfmon_alert((int)level, jamming_alert);
+            }
+            break;
         case 'L':               // list known device types
             (void)
                 fputs
@@ -1270,9 +1575,47 @@ int main(int argc, char **argv)
                 exit(EXIT_FAILURE);
             }
             break;
+        case 'm':
+            if (!metrics_open(optarg)) {
+                exit(EXIT_FAILURE);
+            }
+            break;
         case 'n':
             nmea = true;
             break;
+        case 'p':
+            conninfo = optarg;
+            break;
+        case 'o':
+            if (!txmon_config(optarg)) {
+                (void)fprintf(stderr, "gpsmon: bad poll period %s\n",
+                              optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'q':
+            if (!qgate_config(optarg)) {
+                (void)fprintf(stderr, "gpsmon: bad quality gate %s\n",
+                              optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'R':
+            if (!ubx_reference(optarg)) {
+                (void)fprintf(stderr, "gpsmon: bad reference point %s\n",
+                              optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'r':
+            replay = optarg;
+            break;
+        case 's':
+            seriesname = optarg;
+            break;
+        case 'S':
+            sky_raw(true);
+            break;
         case 't':
             fallback = NULL;
             for (active = monitor_objects; *active; active++) {
@@ -1292,6 +1635,14 @@ int main(int argc, char **argv)
             }
             active = NULL;
             break;
+        case 'u':
+            // the curses monitors need the gpsd driver state
+            ubxonly = true;
+            nocurses = true;
+            break;
+        case 'v':
+            verbosity++;
+            break;
         case 'V':
             (void)printf("%s: %s (revision %s)\n", argv[0], VERSION, REVISION);
             exit(EXIT_SUCCESS);
@@ -1306,6 +1657,19 @@ int main(int argc, char **argv)
         }
     }
 
+    if (!emit_text()) {
+        verbosity = VERB_QUIET;
+    }
+
+    if (NULL != conninfo &&
+        !pgsink_open(conninfo, seriesname)) {
+        exit(EXIT_FAILURE);
+    }
+
+    if (NULL != replay) {
+        exit(gpsmon_replay(replay));
+    }
+
     gpsd_time_init(&context, time(NULL));
     gpsd_init(&session, &context, NULL);
 
@@ -1380,6 +1744,11 @@ int main(int argc, char **argv)
         (void)gps_send(&session.gpsdata, nmea ? WATCHNMEA : WATCHRAW);
     }
 
+    if (ubxonly) {
+        // no lexer to identify it, but -c still needs the UBX driver
+        session.device_type = ubx_mmt.driver;
+    }
+
     /*
      * This is a monitoring utility. Disable autoprobing, because
      * in some cases (e.g. SiRFs) there is no way to probe a chip
@@ -1405,9 +1774,11 @@ int main(int argc, char **argv)
     (void)signal(SIGTERM, onsig);
 
     if (nocurses) {
-        (void)fputs("gpsmon: ", stdout);
-        (void)fputs(promptgen(), stdout);
-        (void)fputs("\n", stdout);
+        if (emit_text()) {
+            (void)fputs("gpsmon: ", stdout);
+            (void)fputs(promptgen(), stdout);
+            (void)fputs("\n", stdout);
+        }
         (void)tcgetattr(0, &cooked);
         (void)tcgetattr(0, &rare);
         rare.c_lflag &=~ (ICANON | ECHO);
@@ -1453,10 +1824,16 @@ int main(int argc, char **argv)
             break;
         }
 
-        switch(gpsd_multipoll(FD_ISSET(session.gpsdata.gps_fd, &rfds),
+        switch(ubxonly ?
+               ubxonly_poll(FD_ISSET(session.gpsdata.gps_fd, &rfds)) :
+               gpsd_multipoll(FD_ISSET(session.gpsdata.gps_fd, &rfds),
                               &session, gpsmon_hook, 0)) {
         case DEVICE_READY:
             FD_SET(session.gpsdata.gps_fd, &all_fds);
+            if (!ubxonly) {
+                metrics_set(M_BYTES, session.lexer.char_counter);
+                metrics_set(M_BADSUM, session.lexer.retry_counter);
+            }
             break;
         case DEVICE_UNREADY:
             bailout = TERM_EMPTY_READ;
@@ -1476,6 +1853,10 @@ int main(int argc, char **argv)
             break;
         }
 
+        pgsink_poll();
+        ubxlink_tick();
+        txmon_tick();
+
         if (FD_ISSET(0, &rfds)) {
             if (curses_active) {
                 cmdline = curses_get_command();
@@ -1484,13 +1865,15 @@ int main(int argc, char **argv)
                 ssize_t st = read(0, &inbuf, 1);
 
                 if (1 == st) {
+                    FILE *prompt = emit_text() ? stdout : stderr;
+
                     report_lock();
                     (void)tcflush(0, TCIFLUSH);
                     (void)tcsetattr(0, TCSANOW, &cooked);
-                    (void)fputs("gpsmon: ", stdout);
-                    (void)fputs(promptgen(), stdout);
-                    (void)fputs("> ", stdout);
-                    (void)putchar(inbuf[0]);
+                    (void)fputs("gpsmon: ", prompt);
+                    (void)fputs(promptgen(), prompt);
+                    (void)fputs("> ", prompt);
+                    (void)fputc(inbuf[0], prompt);
                     cmdline = fgets(inbuf + 1, sizeof(inbuf) - 1, stdin);
                     if (cmdline) {
                         cmdline--;
@@ -1528,6 +1911,13 @@ int main(int argc, char **argv)
     }
 
     gpsd_close(&session);
+    pgsink_close();
+    metrics_close();
+    if (ubxonly) {
+        (void)fprintf(stderr, "gpsmon: %lu frames, %lu bad checksums, "
+                      "%lu bytes skipped\n", ubxlex.st.frames,
+                      ubxlex.st.badsum, ubxlex.st.skipped);
+    }
     if (logfile) {
         (void)fclose(logfile);
     }
@@ -0,0 +1,82 @@
+/* emit.h -- length-prefixed binary records of decoded UBX data
+ *
+ * With --emit=binary[:PATH] every decoded fix, DOP and sky view is
+ * written as one record to stdout or to PATH (typically a FIFO).
+ * Records are in host byte order with naturally aligned fields, so a
+ * consumer on the same host can read them in place.  Each record
+ * starts with struct emit_hdr_t; len counts the whole record.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_EMIT_H_
+#define _GPSD_EMIT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define EMIT_VERSION    1
+
+#define EMIT_FIX        1       // UBX-NAV-SOL
+#define EMIT_DOP        2       // UBX-NAV-DOP
+#define EMIT_SAT        3       // UBX-NAV-SAT
+
+#define EMIT_MAXSATS    64
+
+struct emit_hdr_t {
+    uint16_t len;               // bytes in the record, header included
+    uint8_t type;               // EMIT_*
+    uint8_t version;            // EMIT_VERSION
+};
+
+struct emit_fix_t {
+    struct emit_hdr_t hdr;
+    uint32_t tow;               // GPS time of week, ms
+    int64_t time;               // UTC, us since 1970, INT64_MIN if unknown
+    double lat, lon, alt;       // deg, deg, m above ellipsoid, NaN if unset
+    double ecef[3];             // m
+    double vel[3];              // ECEF velocity, m/s
+    double speed, climb;        // m/s, NaN if unset
+    double eph, epv;            // m
+    double pdop;
+    uint16_t week;
+    uint8_t sats;               // satellites used
+    uint8_t navmode;            // gpsFix
+    uint8_t flags;              // NAV-SOL flags
+    uint8_t pad[3];
+};
+
+struct emit_dop_t {
+    struct emit_hdr_t hdr;
+    uint32_t tow;
+    // 0.01 units: geometric, position, time, vertical, horizontal,
+    // northing, easting
+    uint16_t gdop, pdop, tdop, vdop, hdop, ndop, edop;
+    uint16_t pad;
+};
+
+struct emit_sv_t {
+    uint8_t gnss, sv;
+    uint8_t cno;                // dBHz
+    int8_t elev;                // deg
+    int16_t azim;               // deg
+    uint16_t pad;
+    uint32_t flags;             // NAV-SAT flags
+};
+
+struct emit_sat_t {
+    struct emit_hdr_t hdr;
+    uint32_t tow;
+    uint8_t nsv;                // entries of sv[] that follow
+    uint8_t pad[7];
+    struct emit_sv_t sv[EMIT_MAXSATS];  // only nsv are written
+};
+
+extern bool emit_open(const char *spec);
+extern bool emit_binary(void);
+extern bool emit_text(void);
+extern void emit_record(struct emit_hdr_t *, uint8_t type, size_t len);
+
+#endif  // _GPSD_EMIT_H_
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,38 @@
+/* geo.h -- WGS 84 ECEF, geodetic and local east/north/up conversions
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_GEO_H_
+#define _GPSD_GEO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// local tangent frame at a reference point
+struct geo_enu_t {
+    double ref[3];              // ECEF of the origin, m
+    double r[3][3];             // rows: east, north, up unit vectors
+};
+
+extern void geo_ecef_to_llh(double x, double y, double z,
+                            double *lat, double *lon, double *h);
+extern void geo_ecef_to_llh_n(const double *x, const double *y,
+                              const double *z, double *lat, double *lon,
+                              double *h, size_t n);
+extern void geo_llh_to_ecef(double lat, double lon, double h,
+                            double ecef[3]);
+extern void geo_enu_init(struct geo_enu_t *, double lat, double lon,
+                         double h);
+extern void geo_enu(const struct geo_enu_t *, const double ecef[3],
+                    double enu[3]);
+extern void geo_enu_rotate(const struct geo_enu_t *, const double v[3],
+                           double enu[3]);
+extern bool geo_enu_parse(struct geo_enu_t *, const char *spec);
+extern void geo_enu_n(const struct geo_enu_t *, const double *x,
+                      const double *y, const double *z,
+                      double *e, double *n, double *u, size_t count);
+
+#endif  // _GPSD_GEO_H_
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,18 @@
+/* gnssid.h -- u-blox gnssId/svId to NAV-SVINFO PRN numbers and back
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_GNSSID_H_
+#define _GPSD_GNSSID_H_
+
+#include <stdbool.h>
+
+#define GNSSID_N        8       // gnssId 0..7, GPS .. NavIC
+
+extern unsigned gnssid_prn(unsigned gnss, unsigned sv);
+extern bool gnssid_native(unsigned prn, unsigned *gnss, unsigned *sv);
+
+#endif  // _GPSD_GNSSID_H_
+// vim: set expandtab shiftwidth=4
@@ -32,6 +32,20 @@ extern void monitor_complain(const char *fmt, ...);
 
 #define BUFLEN          2048
 
+// console verbosity, each -v raises it by one
+#define VERB_QUIET      0       // nothing per packet
+#define VERB_FIX        1       // one line per navigation epoch
+#define VERB_SQL        2       // plus an echo of each stored row
+#define VERB_PACKETS    3       // plus a dump of every packet
+extern int verbosity;
+
+// monitor_ubx.c: origin of the stored east/north/up offsets
+extern bool ubx_reference(const char *spec);
+// monitor_ubx.c: program the output profile, period in ms
+extern bool ubx_profile(const char *spec);
+// gpsmon.c: -r, decode a capture of raw UBX ("-" for stdin)
+extern int gpsmon_replay(const char *path);
+
 extern WINDOW *devicewin;
 extern struct gps_device_t      session;
 extern bool serial;     // True - direct mode, False - daemon mode
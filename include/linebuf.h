@@ -0,0 +1,33 @@
+/* linebuf.h -- allocation free text line builder for the console output
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_LINEBUF_H_
+#define _GPSD_LINEBUF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define LINEBUF_LEN     2048
+
+struct linebuf_t {
+    char buf[LINEBUF_LEN];
+    size_t len;
+};
+
+extern void lb_reset(struct linebuf_t *);
+extern void lb_str(struct linebuf_t *, const char *);
+extern void lb_char(struct linebuf_t *, char);
+// printf("%[+]W.Pf"), byte identical to glibc for 0 <= P <= 9
+extern void lb_fixed(struct linebuf_t *, double v, int width, int prec,
+                     bool plus);
+// printf("%[0]Wld")
+extern void lb_long(struct linebuf_t *, long v, int width, bool zero);
+// printf("%0Wlx")
+extern void lb_hex(struct linebuf_t *, unsigned long v, int width);
+extern void lb_write(struct linebuf_t *, int fd);
+
+#endif  // _GPSD_LINEBUF_H_
+// vim: set expandtab shiftwidth=4
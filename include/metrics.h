@@ -0,0 +1,59 @@
+/* metrics.h -- ingest counters, exported as a Prometheus text file
+ *
+ * The hot path only does relaxed atomic adds and stores; a separate
+ * thread formats and writes the file.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_METRICS_H_
+#define _GPSD_METRICS_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define METRICS_SEC     10      // export interval
+
+#define M_BYTES         0       // bytes read from the receiver
+#define M_BADSUM        1       // lexer checksum failures and retries
+#define M_ROWS          2       // rows committed to the database
+#define M_LOST          3       // rows lost to failed COPYs
+#define M_DBERRORS      4       // failed statements
+#define M_RECONNECTS    5       // connection resets
+#define M_QUEUED        6       // rows waiting in COPY buffers (gauge)
+#define M_REJECTS       7       // epochs refused by the quality gate
+#define M_TXPEAK        8       // receiver TX buffer peak, % (gauge)
+#define M_OVERLOAD      9       // TXMON_* bottleneck (gauge)
+#define M_COPY_MS       10      // round trip of the last COPY (gauge)
+#define M_NMETRICS      11
+
+extern atomic_ulong metrics[M_NMETRICS];
+extern atomic_ulong metrics_class[256];
+
+static inline void metrics_add(int m, unsigned long n)
+{
+    atomic_fetch_add_explicit(&metrics[m], n, memory_order_relaxed);
+}
+
+static inline void metrics_set(int m, unsigned long v)
+{
+    atomic_store_explicit(&metrics[m], v, memory_order_relaxed);
+}
+
+static inline unsigned long metrics_get(int m)
+{
+    return atomic_load_explicit(&metrics[m], memory_order_relaxed);
+}
+
+// one UBX packet of message class cls
+static inline void metrics_packet(unsigned char cls)
+{
+    atomic_fetch_add_explicit(&metrics_class[cls], 1, memory_order_relaxed);
+}
+
+extern bool metrics_open(const char *path);
+extern void metrics_close(void);
+
+#endif  // _GPSD_METRICS_H_
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,20 @@
+/* passes.h -- per-satellite pass summaries from NAV-SAT epochs
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_PASSES_H_
+#define _GPSD_PASSES_H_
+
+#include "gnssid.h"
+#include "sky.h"
+
+#define PASSES_MAXOPEN  128     // satellites above the horizon at once
+#define PASSES_GAP_SEC  120     // longer unseen ends the pass
+#define PASSES_MIN_EL   0       // degrees, lowest elevation of a pass
+
+extern void passes_epoch(const struct sky_epoch_t *);
+
+#endif  // _GPSD_PASSES_H_
+// vim: set expandtab shiftwidth=4
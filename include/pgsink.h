@@ -0,0 +1,73 @@
+/* pgsink.h -- batched binary COPY of decoded UBX data into PostgreSQL
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_PGSINK_H_
+#define _GPSD_PGSINK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define PGSINK_MAXSTREAMS       8       // tables fed by one process
+#define PGCOPY_BUFLEN           65536   // pending tuples per stream
+#define PGSINK_BATCH_ROWS       32      // first batch size, rows
+#define PGSINK_BATCH_MAX        1024    // largest batch the tuning may reach
+#define PGSINK_FLUSH_MS         5000    // default age bound of a queued row
+#define PGSINK_DUTY_PCT         10      // most of the time a stream may flush
+#define PGSINK_MAXHOOKS         8       // modules with a poll/close hook
+#define PGSINK_SERIES_CHARS     80      // "Серии"."Название" varchar(80)
+
+// PostgreSQL epoch in Unix microseconds
+#define PG_UNIX_EPOCH_USEC      (946684800LL * 1000000)
+
+/* One COPY ... FROM STDIN (FORMAT binary) target.  Tuples are encoded
+ * straight into buf and shipped in one PQputCopyData() per flush. */
+struct pgcopy_t {
+    char stmt[512];                     // COPY statement for this target
+    unsigned char buf[PGCOPY_BUFLEN];
+    size_t len;                         // bytes of complete tuples in buf
+    size_t row_start;                   // offset of the tuple being built
+    bool overflow;                      // tuple did not fit, drop it
+    unsigned rows;                      // complete tuples in buf
+    struct timespec first;              // CLOCK_MONOTONIC of oldest tuple
+    unsigned batch;                     // flush at this many rows, tuned
+    struct timespec flushed;            // start of the last flush
+};
+
+extern bool pgsink_open(const char *conninfo, const char *series);
+extern bool pgsink_freshness(const char *spec);
+extern void pgsink_close(void);
+extern bool pgsink_active(void);
+extern long pgsink_series_id(void);
+extern struct pgcopy_t *pgsink_stream(const char *schema, const char *table,
+                                      const char *columns, bool partitioned);
+extern void pgsink_poll(void);
+extern bool pgsink_flush(struct pgcopy_t *);
+extern bool pgsink_params(const char *sql, int nparams,
+                          const char *const *values);
+/* fn(false) runs on every pgsink_poll(), fn(true) once from
+ * pgsink_close() while the connection is still up */
+extern void pgsink_hook(void (*fn)(bool final));
+
+// tuple builders, fields must be added in column order
+extern void pgcopy_row(struct pgcopy_t *, int nfields);
+extern void pgcopy_null(struct pgcopy_t *);
+extern void pgcopy_int2(struct pgcopy_t *, int);
+extern void pgcopy_int2_array(struct pgcopy_t *, const int16_t *,
+                              unsigned n);
+extern void pgcopy_int4(struct pgcopy_t *, long);
+extern void pgcopy_int8(struct pgcopy_t *, int64_t);
+extern void pgcopy_float8(struct pgcopy_t *, double);
+extern void pgcopy_bool(struct pgcopy_t *, bool);
+extern void pgcopy_bool_array(struct pgcopy_t *, const bool *, unsigned n);
+extern void pgcopy_text(struct pgcopy_t *, const char *);
+extern void pgcopy_time(struct pgcopy_t *, int64_t usec);
+extern void pgcopy_timespec(struct pgcopy_t *, const struct timespec *);
+extern void pgcopy_commit(struct pgcopy_t *);
+
+#endif  // _GPSD_PGSINK_H_
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,31 @@
+/* posstats.h -- running position statistics of the current series
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_POSSTATS_H_
+#define _GPSD_POSSTATS_H_
+
+#define POSSTATS_SAVE_SEC       10      // summary row refresh interval
+
+/* Welford accumulators.  Position is accumulated in ECEF, where the
+ * mean and covariance are plain vector sums; the covariance is turned
+ * into the local east/north/up frame only when it is read out. */
+struct posstats_t {
+    unsigned long n;
+    double mean[3];             // ECEF, m
+    double m2[6];               // co-moments xx, xy, xz, yy, yz, zz, m^2
+    double min[3], max[3];      // latitude, longitude, altitude
+};
+
+extern void posstats_add(struct posstats_t *, const double ecef[3],
+                         double lat, double lon, double alt);
+extern void posstats_enu(const struct posstats_t *, double lat, double lon,
+                         double cov[6]);
+extern void posstats_fix(const double ecef[3],
+                         double lat, double lon, double alt);
+extern void posstats_rejected(void);
+
+#endif  // _GPSD_POSSTATS_H_
+// vim: set expandtab shiftwidth=4
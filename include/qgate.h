@@ -0,0 +1,32 @@
+/* qgate.h -- fix quality gate in front of storage
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_QGATE_H_
+#define _GPSD_QGATE_H_
+
+#include <stdbool.h>
+
+#define QGATE_MAXWIN    63      // longest median/MAD window
+
+// verdicts, also indexes of qgate_rejects[]; QGATE_OK counts the stored
+#define QGATE_OK        0
+#define QGATE_NOPOS     1       // no position, or receiver says fix not OK
+#define QGATE_FIX       2       // fix type below fix=
+#define QGATE_SATS      3       // fewer satellites than sats=
+#define QGATE_PDOP      4       // pDOP above pdop=
+#define QGATE_ACC       5       // 3D accuracy estimate above acc=
+#define QGATE_OUTLIER   6       // farther from the median than mad= MADs
+#define QGATE_VERDICTS  7
+
+extern unsigned long qgate_rejects[QGATE_VERDICTS];
+
+extern bool qgate_config(const char *spec);
+extern int qgate_check(unsigned navmode, unsigned flags, int sats,
+                       double pdop, double acc, const double *ecef);
+extern unsigned long qgate_rejected(void);
+
+#endif  // _GPSD_QGATE_H_
+// vim: set expandtab shiftwidth=4
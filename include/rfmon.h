@@ -0,0 +1,36 @@
+/* rfmon.h -- RF front end samples from MON-RF/MON-HW, jamming alert
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_RFMON_H_
+#define _GPSD_RFMON_H_
+
+#include <stdbool.h>
+#include <time.h>
+
+#define RFMON_BLOCKS    2       // RF blocks kept, MON-RF blockId
+#define RFMON_SAMPLES   60      // samples per stored row
+
+// one sample, indexes of the v[] given to rfmon_sample()
+#define RFMON_NOISE     0       // noise level, per ms
+#define RFMON_AGC       1       // AGC monitor count, 0..8191
+#define RFMON_JAM       2       // CW jamming indicator, 0..255
+#define RFMON_JAMSTATE  3       // 0 unknown, 1 OK, 2 warning, 3 critical
+#define RFMON_ANT       4       // antenna status, 0 init .. 4 open
+#define RFMON_ANTPOWER  5       // antenna power, 0 off, 1 on, 2 unknown
+#define RFMON_MAGI      6       // I part magnitude, 0..255
+#define RFMON_MAGQ      7       // Q part magnitude, 0..255
+#define RFMON_FIELDS    8
+
+/* called on every sample that takes the jamming indicator to or above
+ * the threshold, or back below it */
+typedef void (*rfmon_alert_t)(unsigned block, int jam, bool jammed);
+
+extern void rfmon_alert(int threshold, rfmon_alert_t fn);
+extern void rfmon_sample(unsigned block, const int v[RFMON_FIELDS],
+                         const struct timespec *rx);
+
+#endif  // _GPSD_RFMON_H_
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,17 @@
+/* rollup.h -- 1 s, 10 s and 1 min aggregates of the stored fixes
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_ROLLUP_H_
+#define _GPSD_ROLLUP_H_
+
+#include <stdint.h>
+
+extern void rollup_fix(int64_t pg_usec, const double ecef[3],
+                       double lat, double lon, double alt,
+                       int sats, double pdop);
+
+#endif  // _GPSD_ROLLUP_H_
+// vim: set expandtab shiftwidth=4
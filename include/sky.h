@@ -0,0 +1,37 @@
+/* sky.h -- one row of satellite arrays per NAV-SAT epoch
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_SKY_H_
+#define _GPSD_SKY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#define SKY_MAXSV       128     // satellites kept from one NAV-SAT
+#define SKY_FL_ORBIT    0x0700  // orbitSource in fl, 0 for no orbit known
+
+// one epoch, column by column as it is stored
+struct sky_epoch_t {
+    unsigned long tow;                  // iTOW, ms
+    struct timespec time;               // the same as UTC, 0 if no week yet
+    unsigned n;
+    int16_t gnss[SKY_MAXSV];            // gnssId
+    int16_t sv[SKY_MAXSV];              // svId
+    int16_t prn[SKY_MAXSV];             // NAV-SVINFO numbering
+    int16_t az[SKY_MAXSV];              // azimuth, degrees
+    int16_t el[SKY_MAXSV];              // elevation, degrees
+    int16_t ss[SKY_MAXSV];              // C/N0, dBHz
+    int16_t fl[SKY_MAXSV];              // low half of the NAV-SAT flags
+    bool used[SKY_MAXSV];               // used in the navigation solution
+};
+
+extern void sky_raw(bool on);
+extern void sky_epoch(const struct sky_epoch_t *,
+                      const struct timespec *rx);
+
+#endif  // _GPSD_SKY_H_
+// vim: set expandtab shiftwidth=4
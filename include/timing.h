@@ -0,0 +1,20 @@
+/* timing.h -- TIM-TP pulses paired with kernel PPS, TIM-TM2 events
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_TIMING_H_
+#define _GPSD_TIMING_H_
+
+#include <stdbool.h>
+#include <time.h>
+
+extern void timing_tp(const struct timespec *pulse, long qerr_ps,
+                      bool qerr_ok, const struct timespec *rx);
+extern void timing_tm2(unsigned ch, unsigned count,
+                       const struct timespec *rise,
+                       const struct timespec *fall, unsigned long acc_ns);
+
+#endif  // _GPSD_TIMING_H_
+// vim: set expandtab shiftwidth=4
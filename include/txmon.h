@@ -0,0 +1,27 @@
+/* txmon.h -- receiver TX buffer polling and overload diagnosis
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_TXMON_H_
+#define _GPSD_TXMON_H_
+
+#include <stdbool.h>
+
+#define TXMON_PEAK      90      // %, receiver TX buffer peak that is overload
+#define TXMON_BACKLOG   4096    // bytes unread in the host tty queue
+#define TXMON_QUEUED    1024    // rows waiting for the database
+
+// verdicts, also the M_OVERLOAD gauge
+#define TXMON_NONE      0
+#define TXMON_LINK      1       // the receiver can't get its output out
+#define TXMON_PARSER    2       // we don't read what has arrived
+#define TXMON_DATABASE  3       // the database holds up the loop
+
+extern bool txmon_config(const char *spec);
+extern void txmon_receiver(unsigned peak, bool dropped);
+extern void txmon_tick(void);
+
+#endif  // _GPSD_TXMON_H_
+// vim: set expandtab shiftwidth=4
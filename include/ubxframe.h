@@ -0,0 +1,56 @@
+/* ubxframe.h -- fast framing of a pure UBX byte stream
+ *
+ * A UBX frame is 0xb5 0x62, class, id, little endian payload length,
+ * payload, and an 8-bit Fletcher checksum over class..payload.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_UBXFRAME_H_
+#define _GPSD_UBXFRAME_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define UBX_SYNC1       0xb5
+#define UBX_SYNC2       0x62
+#define UBX_HDR_LEN     6       // sync, class, id, length
+#define UBX_FRAME_MAX   9216    // MAX_PACKET_LENGTH, whole frame
+
+struct ubxscan_t {
+    unsigned long frames;       // good frames delivered
+    unsigned long badsum;       // complete frames failing the checksum
+    unsigned long skipped;      // bytes dropped outside of frames
+};
+
+/* Streaming UBX-only lexer.  The whole state is this struct, well
+ * inside one cache line; the frame is assembled in a caller supplied
+ * buffer of UBX_FRAME_MAX bytes. */
+struct ubxlex_t {
+    unsigned char *frame;
+    unsigned short have;        // bytes of the frame collected
+    unsigned short need;        // bytes still missing for the next step
+    unsigned char state;        // UBXLEX_*
+    struct ubxscan_t st;
+};
+
+#define UBXLEX_SYNC1    0       // hunting for 0xb5
+#define UBXLEX_SYNC2    1       // 0xb5 seen, want 0x62
+#define UBXLEX_HEADER   2       // collecting class, id, length
+#define UBXLEX_BODY     3       // collecting payload and checksum
+
+typedef void (*ubx_frame_cb)(const unsigned char *frame, size_t len,
+                             void *arg);
+
+extern void ubx_checksum(const unsigned char *p, size_t n,
+                         unsigned char *ck_a, unsigned char *ck_b);
+extern bool ubx_frame_ok(const unsigned char *frame, size_t len);
+extern size_t ubx_scan(struct ubxscan_t *, const unsigned char *buf,
+                       size_t len, ubx_frame_cb, void *arg);
+extern void ubxlex_init(struct ubxlex_t *, unsigned char *frame);
+extern void ubxlex_feed(struct ubxlex_t *, const unsigned char *buf,
+                        size_t len, ubx_frame_cb, void *arg);
+
+#endif  // _GPSD_UBXFRAME_H_
+// vim: set expandtab shiftwidth=4
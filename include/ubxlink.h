@@ -0,0 +1,21 @@
+/* ubxlink.h -- UART rate upgrade and UBX-only port setup
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#ifndef _GPSD_UBXLINK_H_
+#define _GPSD_UBXLINK_H_
+
+#include <stdbool.h>
+
+#define UBXLINK_VERIFY_SEC      2       // wait this long for the ACK
+#define UBXLINK_MEASURE_SEC     10      // then measure utilisation this long
+
+extern bool ubxlink_config(const char *spec);
+extern void ubxlink_start(void);
+extern void ubxlink_ack(unsigned msgid, bool ack);
+extern void ubxlink_tick(void);
+
+#endif  // _GPSD_UBXLINK_H_
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,214 @@
+/*
+ * Allocation free text line builder.
+ *
+ * The console line of each epoch is assembled in one reusable buffer
+ * and written with a single write(2).  Doubles are formatted by
+ * lb_fixed() instead of printf(): the value is taken apart into its
+ * integer mantissa and binary exponent and rounded exactly (half to
+ * even, like glibc) in 128-bit integer arithmetic, so the output is
+ * byte identical to "%W.Pf" but does not depend on the locale.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "include/linebuf.h"
+
+static const uint64_t pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL,
+};
+
+void lb_reset(struct linebuf_t *lb)
+{
+    lb->len = 0;
+}
+
+static void lb_mem(struct linebuf_t *lb, const char *s, size_t n)
+{
+    if (sizeof(lb->buf) - lb->len < n) {
+        n = sizeof(lb->buf) - lb->len;          // truncate, like snprintf
+    }
+    memcpy(lb->buf + lb->len, s, n);
+    lb->len += n;
+}
+
+void lb_str(struct linebuf_t *lb, const char *s)
+{
+    lb_mem(lb, s, strlen(s));
+}
+
+void lb_char(struct linebuf_t *lb, char c)
+{
+    lb_mem(lb, &c, 1);
+}
+
+// right-justify s (n bytes) in a field of width, padded with spaces
+static void lb_pad(struct linebuf_t *lb, const char *s, size_t n, int width)
+{
+    static const char spaces[] = "                                ";
+
+    while (0 < width &&
+           (size_t)width > n) {
+        size_t pad = (size_t)width - n;
+
+        if (sizeof(spaces) - 1 < pad) {
+            pad = sizeof(spaces) - 1;
+        }
+        lb_mem(lb, spaces, pad);
+        width -= (int)pad;
+    }
+    lb_mem(lb, s, n);
+}
+
+void lb_fixed(struct linebuf_t *lb, double v, int width, int prec, bool plus)
+{
+    char tmp[48];
+    char *p = tmp + sizeof(tmp);
+    uint64_t bits, mant, n;
+    int exp, i;
+    bool neg = 0 != signbit(v);
+
+    if (!isfinite(v)) {
+        const char *s = isnan(v) ? "nan" : "inf";
+
+        *--p = s[2], *--p = s[1], *--p = s[0];
+        if (neg || plus) {
+            *--p = neg ? '-' : '+';
+        }
+        lb_pad(lb, p, (size_t)(tmp + sizeof(tmp) - p), width);
+        return;
+    }
+    if (0 > prec ||
+        9 < prec ||
+        1e9 <= fabs(v)) {
+        // outside the exact fast path, rare
+        size_t room = sizeof(lb->buf) - lb->len;
+        int len = snprintf(lb->buf + lb->len, room,
+                           plus ? "%+*.*f" : "%*.*f", width, prec, v);
+
+        if (0 < len &&
+            0 < room) {
+            lb->len += (size_t)len < room ? (size_t)len : room - 1;
+        }
+        return;
+    }
+
+    memcpy(&bits, &v, sizeof(bits));
+    exp = (int)((bits >> 52) & 0x7ff);
+    mant = bits & ((1ULL << 52) - 1);
+    if (0 == exp) {
+        exp = 1;                // subnormal
+    } else {
+        mant |= 1ULL << 52;
+    }
+    exp -= 1075;                // |v| == mant * 2^exp
+
+    // |v| < 1e9 < 2^52 so exp < 0, and mant * 10^9 < 2^83 fits in 128 bits
+    {
+        unsigned __int128 q = (unsigned __int128)mant * pow10[prec];
+        int s = -exp;
+
+        if (128 <= s) {
+            n = 0;              // far below half of the last digit
+        } else {
+            unsigned __int128 one = 1;
+            unsigned __int128 rem = q & ((one << s) - 1);
+            unsigned __int128 half = one << (s - 1);
+
+            n = (uint64_t)(q >> s);
+            if (rem > half ||
+                (rem == half && 0 != (n & 1))) {
+                n++;
+            }
+        }
+    }
+
+    for (i = 0; i < prec; i++) {
+        *--p = (char)('0' + n % 10);
+        n /= 10;
+    }
+    if (0 < prec) {
+        *--p = '.';
+    }
+    do {
+        *--p = (char)('0' + n % 10);
+        n /= 10;
+    } while (0 != n);
+    if (neg || plus) {
+        *--p = neg ? '-' : '+';
+    }
+    lb_pad(lb, p, (size_t)(tmp + sizeof(tmp) - p), width);
+}
+
+void lb_long(struct linebuf_t *lb, long v, int width, bool zero)
+{
+    char tmp[24];
+    char *p = tmp + sizeof(tmp);
+    unsigned long u = 0 > v ? 0UL - (unsigned long)v : (unsigned long)v;
+    int digits = 0;
+
+    do {
+        *--p = (char)('0' + u % 10);
+        u /= 10;
+        digits++;
+    } while (0 != u);
+    if (zero) {
+        // the sign counts against the width, like printf
+        while (digits + (0 > v) < width &&
+               p > tmp + 1) {
+            *--p = '0';
+            digits++;
+        }
+    }
+    if (0 > v) {
+        *--p = '-';
+    }
+    lb_pad(lb, p, (size_t)(tmp + sizeof(tmp) - p), width);
+}
+
+void lb_hex(struct linebuf_t *lb, unsigned long v, int width)
+{
+    static const char hexdigits[] = "0123456789abcdef";
+    char tmp[24];
+    char *p = tmp + sizeof(tmp);
+
+    do {
+        *--p = hexdigits[v & 0x0f];
+        v >>= 4;
+    } while (0 != v);
+    while (tmp + sizeof(tmp) - p < width &&
+           p > tmp) {
+        *--p = '0';
+    }
+    lb_mem(lb, p, (size_t)(tmp + sizeof(tmp) - p));
+}
+
+// one write(2) for the whole line, after whatever stdio still holds
+void lb_write(struct linebuf_t *lb, int fd)
+{
+    const char *p = lb->buf;
+    size_t left = lb->len;
+
+    (void)fflush(stdout);
+    while (0 < left) {
+        ssize_t st = write(fd, p, left);
+
+        if (0 >= st) {
+            break;
+        }
+        p += st;
+        left -= (size_t)st;
+    }
+    lb->len = 0;
+}
+
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,191 @@
+/*
+ * Ingest counters, exported as a Prometheus text file.
+ *
+ * Counters are updated with relaxed atomics wherever the event happens.
+ * Every METRICS_SEC a detached thread reads them, formats the
+ * exposition text and replaces the file by rename(), so a
+ * node_exporter textfile collector never sees a partial file and the
+ * ingest loop never waits for the disk.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "include/metrics.h"
+
+#define METRIC_PREFIX  "pgubxgpsmon_"
+
+atomic_ulong metrics[M_NMETRICS];
+atomic_ulong metrics_class[256];
+
+static char path[256], tmppath[264];
+static pthread_mutex_t file_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const struct {
+    const char *name, *type, *help;
+} descr[M_NMETRICS] = {
+    {"bytes_total", "counter", "Bytes read from the receiver"},
+    {"checksum_errors_total", "counter",
+     "Packets failing the checksum, or lexer retries"},
+    {"rows_total", "counter", "Rows committed to PostgreSQL"},
+    {"rows_lost_total", "counter", "Rows lost to failed COPYs"},
+    {"db_errors_total", "counter", "Failed database statements"},
+    {"db_reconnects_total", "counter", "Database connection resets"},
+    {"rows_queued", "gauge", "Rows waiting in COPY buffers"},
+    {"rejected_total", "counter", "Epochs refused by the quality gate"},
+    {"receiver_tx_peak_percent", "gauge",
+     "Receiver TX buffer peak usage over the last poll"},
+    {"overload", "gauge",
+     "Bottleneck: 0 none, 1 link, 2 parser, 3 database"},
+    {"copy_milliseconds", "gauge", "Round trip of the last COPY batch"},
+};
+
+static const char *class_name(unsigned cls)
+{
+    switch (cls) {
+    case 0x01:
+        return "NAV";
+    case 0x02:
+        return "RXM";
+    case 0x04:
+        return "INF";
+    case 0x05:
+        return "ACK";
+    case 0x06:
+        return "CFG";
+    case 0x09:
+        return "UPD";
+    case 0x0a:
+        return "MON";
+    case 0x0b:
+        return "AID";
+    case 0x0d:
+        return "TIM";
+    case 0x10:
+        return "ESF";
+    case 0x13:
+        return "MGA";
+    case 0x21:
+        return "LOG";
+    case 0x27:
+        return "SEC";
+    case 0x28:
+        return "HNR";
+    default:
+        return NULL;
+    }
+}
+
+static void metrics_write(void)
+{
+    char text[8192];
+    size_t len = 0;
+    unsigned i;
+    int fd;
+
+#define OUT(...)                                                        \
+    do {                                                                \
+        int w = snprintf(text + len, sizeof(text) - len, __VA_ARGS__);  \
+        if (0 < w &&                                                    \
+            sizeof(text) - len > (size_t)w) {                           \
+            len += (size_t)w;                                           \
+        }                                                               \
+    } while (0)
+
+    for (i = 0; i < M_NMETRICS; i++) {
+        OUT("# HELP " METRIC_PREFIX "%s %s\n# TYPE " METRIC_PREFIX "%s %s\n"
+            METRIC_PREFIX "%s %lu\n",
+            descr[i].name, descr[i].help, descr[i].name, descr[i].type,
+            descr[i].name,
+            atomic_load_explicit(&metrics[i], memory_order_relaxed));
+    }
+    OUT("# HELP " METRIC_PREFIX "packets_total UBX packets received by class\n"
+        "# TYPE " METRIC_PREFIX "packets_total counter\n");
+    for (i = 0; i < 256; i++) {
+        unsigned long n = atomic_load_explicit(&metrics_class[i],
+                                               memory_order_relaxed);
+        const char *name = class_name(i);
+
+        if (0 == n) {
+            continue;
+        }
+        if (NULL != name) {
+            OUT(METRIC_PREFIX "packets_total{class=\"%s\"} %lu\n", name, n);
+        } else {
+            OUT(METRIC_PREFIX "packets_total{class=\"0x%02x\"} %lu\n", i, n);
+        }
+    }
+#undef OUT
+
+    // the thread and metrics_close() share tmppath
+    (void)pthread_mutex_lock(&file_lock);
+    fd = open(tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (0 > fd) {
+        (void)pthread_mutex_unlock(&file_lock);
+        return;
+    }
+    if ((ssize_t)len == write(fd, text, len)) {
+        (void)close(fd);
+        (void)rename(tmppath, path);
+    } else {
+        (void)close(fd);
+        (void)unlink(tmppath);
+    }
+    (void)pthread_mutex_unlock(&file_lock);
+}
+
+static void *metrics_thread(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        (void)sleep(METRICS_SEC);
+        metrics_write();
+    }
+    return NULL;
+}
+
+// start exporting to path, a file name in the textfile collector directory
+bool metrics_open(const char *name)
+{
+    pthread_t tid;
+    pthread_attr_t attr;
+    int err;
+
+    if (sizeof(path) <= strlen(name)) {
+        return false;
+    }
+    (void)snprintf(path, sizeof(path), "%s", name);
+    (void)snprintf(tmppath, sizeof(tmppath), "%s.tmp", name);
+
+    (void)pthread_attr_init(&attr);
+    (void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    err = pthread_create(&tid, &attr, metrics_thread, NULL);
+    (void)pthread_attr_destroy(&attr);
+    if (0 != err) {
+        (void)fprintf(stderr, "metrics: can't start thread: %s\n",
+                      strerror(err));
+        return false;
+    }
+    return true;
+}
+
+/* Write the file once more at exit, after the last rows were flushed,
+ * so it does not stay up to METRICS_SEC behind. */
+void metrics_close(void)
+{
+    if ('\0' != path[0]) {
+        metrics_write();
+    }
+}
+
+// vim: set expandtab shiftwidth=4
@@ -6,21 +6,116 @@
 #include "include/gpsd_config.h"  // must be before all includes
 
 #include <math.h>
+#include <stddef.h>           // for offsetof()
 #include <stdint.h>           // for int64_t (tow in display_ubx_nav)
+#include <limits.h>           // for ULONG_MAX
 #include <stdlib.h>           // for labs()
 #include <string.h>           // for memset()
 #include <time.h>
 #include <stdio.h>
-#include "libpq-fe.h"
+#include <unistd.h>           // for STDOUT_FILENO
 
 #include "include/gpsd.h"
 #include "include/bits.h"
 #include "include/gpsmon.h"
 
 #include "include/driver_ubx.h"
+#include "include/emit.h"
+#include "include/geo.h"
+#include "include/gnssid.h"
+#include "include/linebuf.h"
+#include "include/passes.h"
+#include "include/pgsink.h"
+#include "include/posstats.h"
+#include "include/qgate.h"
+#include "include/rfmon.h"
+#include "include/rollup.h"
+#include "include/sky.h"
+#include "include/timing.h"
+#include "include/txmon.h"
+#include "include/ubxlink.h"
 extern const struct gps_type_t driver_ubx;
 static WINDOW *satwin, *navsolwin, *dopwin;
 
+// console text of the current epoch
+static struct linebuf_t line;
+
+// target of NAV-SOL rows, leaf partition of the current series
+static struct pgcopy_t *fixcopy;
+
+// nominal point of the series, from -R
+static struct geo_enu_t reference;
+static bool have_reference;
+#define FIX_COLUMNS "\"Серия\", φ, λ, h, epx, epz, evx, evy, evz, v, clm, " \
+                    "\"День недели\", \"UTC\", epx1, epv, \"Спутников\", " \
+                    "dop, \"Режим\", flg, \"Время\", \"ΔE\", \"ΔN\", \"ΔU\", " \
+                    "\"PPS\", \"Приём\""
+#define FIX_FIELDS  25
+
+// GPS epoch 1980-01-06 is 7300 days before the PostgreSQL epoch 2000-01-01
+#define GPS_PG_EPOCH_USEC       (-7300LL * 86400 * 1000000)
+// GPS epoch in Unix seconds
+#define GPS_UNIX_EPOCH          315964800LL
+
+/* Output profile programmed with -c: everything ubx_update() decodes at
+ * the given rate, the NAV and NMEA outputs it would discard turned off.
+ * Rates are per navigation solution, for the port the command arrives
+ * on. */
+static const struct {
+    unsigned short msgid;
+    unsigned char rate;
+} profile[] = {
+    {UBX_MSGID(UBX_CLASS_NMEA, 0x00), 0},       // GGA
+    {UBX_MSGID(UBX_CLASS_NMEA, 0x01), 0},       // GLL
+    {UBX_MSGID(UBX_CLASS_NMEA, 0x02), 0},       // GSA
+    {UBX_MSGID(UBX_CLASS_NMEA, 0x03), 0},       // GSV
+    {UBX_MSGID(UBX_CLASS_NMEA, 0x04), 0},       // RMC
+    {UBX_MSGID(UBX_CLASS_NMEA, 0x05), 0},       // VTG
+    {UBX_MSGID(UBX_CLASS_NMEA, 0x08), 0},       // ZDA
+    {UBX_NAV_CLOCK, 0},
+    {UBX_NAV_EOE, 0},
+    {UBX_NAV_POSECEF, 0},
+    {UBX_NAV_POSLLH, 0},
+    {UBX_NAV_PVT, 0},
+    {UBX_NAV_STATUS, 0},
+    {UBX_NAV_SVINFO, 1},                        // off once NAV-SAT comes
+    {UBX_NAV_TIMEGPS, 0},
+    {UBX_NAV_VELECEF, 0},
+    {UBX_NAV_VELNED, 0},
+    {UBX_NAV_SOL, 1},
+    {UBX_NAV_DOP, 1},
+    {UBX_NAV_SAT, 1},
+    {UBX_NAV_TIMEUTC, 1},
+    {UBX_NAV_TIMELS, 60},                       // changes twice a year
+    {UBX_TIM_TP, 1},
+    {UBX_TIM_TM2, 1},                           // only when EXTINT fires
+    {UBX_MON_RF, 1},                            // NAKed before protocol 27
+    {UBX_MON_HW, 1},
+    {UBX_MON_HW2, 1},
+};
+static unsigned profile_ms;         // -c measurement period, 0 for none
+static bool profile_sent;
+/* CFG-MSG commands sent, in order.  The ACK or NAK names only CFG-MSG,
+ * but the receiver answers in the order it got them: the n-th answer is
+ * about asked[n].  One more slot for NAV-SVINFO off. */
+static struct {
+    unsigned short msgid[sizeof(profile) / sizeof(profile[0]) + 1];
+    unsigned n, answered;
+} asked;
+
+// GPS-UTC offset, from NAV-TIMELS or NAV-TIMEUTC when the receiver sends them
+static int leap_seconds;
+static bool leap_valid;
+static bool leap_timels;            // from NAV-TIMELS, NAV-TIMEUTC ignored
+static int last_week = -1;          // GPS week of the last NAV-SOL
+static unsigned long last_tow;      // and its iTOW, ms
+
+/* Host clock at the first packet of the current epoch's burst: the NAV
+ * messages of one epoch share their iTOW, the first with a new one
+ * starts the burst. */
+static unsigned long burst_tow = ULONG_MAX;
+static timespec_t burst_time;
+
 #define display (void)mvwprintw
 
 // FIXME: Lock what?  Why?  Where?
@@ -100,6 +195,31 @@ static void display_nav_sat(unsigned char *buf, size_t data_len)
     }
 
     nchan = getub(buf, 5);
+    if (emit_binary()) {
+        struct emit_sat_t rec;
+
+        rec.tow = (uint32_t)getleu32(buf, 0);
+        rec.nsv = 0;
+        memset(rec.pad, 0, sizeof(rec.pad));
+        for (i = 0; i < nchan && i < EMIT_MAXSATS; i++) {
+            struct emit_sv_t *sv = &rec.sv[i];
+
+            off = 8 + 12 * i;
+            if (off + 12 > data_len) {
+                break;
+            }
+            sv->gnss = getub(buf, off);
+            sv->sv = getub(buf, off + 1);
+            sv->cno = getub(buf, off + 2);
+            sv->elev = getsb(buf, off + 3);
+            sv->azim = getles16(buf, off + 4);
+            sv->pad = 0;
+            sv->flags = (uint32_t)getleu32(buf, off + 8);
+            rec.nsv++;
+        }
+        emit_record(&rec.hdr, EMIT_SAT, offsetof(struct emit_sat_t, sv) +
+                    rec.nsv * sizeof(struct emit_sv_t));
+    }
     if (nchan > MAXSKYCHANS) {
         nchan = MAXSKYCHANS;
     }
@@ -115,26 +235,22 @@ static void display_nav_sat(unsigned char *buf, size_t data_len)
         az = getles16(buf, off + 4);
 
         // Translate sat numbering to the one used in UBX-NAV-SVINFO
-        if (gnss == 2) {
-            prn += 210;  // Galileo
-        } else if (gnss == 3 && prn <= 5) {
-            prn += 158;  // BeiDou
-        } else if (gnss == 3 && prn >= 6) {
-            prn += 27;   // BeiDou (continued)
-        } else if (gnss == 4) {
-            prn += 172;  // IMES
-        } else if (gnss == 5) {
-            prn += 192;  // QZSS
-        } else if (gnss == 6 && prn != 255) {
-            prn += 64;   // GLONASS
-        }
+        prn = gnssid_prn(gnss, prn);
 
         (void)mvwprintw(satwin, i + 2, 4, "%3d %3d %3d  %2d %04x %c",
                         prn, az, el, ss, fl,
                         (fl & (UBX_SAT_USED << 3)) ? 'Y' : ' ');
     }
-    printf( " спутников %2d ", session.gpsdata.satellites_used);
-    printf (" доп %5.1f ", session.gpsdata.dop.pdop);
+    if (VERB_FIX <= verbosity) {
+        // written now, so it keeps its place among the console output
+        lb_reset(&line);
+        lb_str(&line, " спутников ");
+        lb_long(&line, session.gpsdata.satellites_used, 2, false);
+        lb_str(&line, "  доп ");
+        lb_fixed(&line, session.gpsdata.dop.pdop, 5, 1, false);
+        lb_char(&line, ' ');
+        lb_write(&line, STDOUT_FILENO);
+    }
 #undef SV
 
     // clear potentially stale sat lines unconditionally
@@ -160,6 +276,20 @@ static void display_nav_dop(unsigned char *buf, size_t data_len)
     if (data_len != 18) {
         return;
     }
+    if (emit_binary()) {
+        struct emit_dop_t rec;
+
+        rec.tow = (uint32_t)getleu32(buf, 0);
+        rec.gdop = getleu16(buf, 4);
+        rec.pdop = getleu16(buf, 6);
+        rec.tdop = getleu16(buf, 8);
+        rec.vdop = getleu16(buf, 10);
+        rec.hdop = getleu16(buf, 12);
+        rec.ndop = getleu16(buf, 14);
+        rec.edop = getleu16(buf, 16);
+        rec.pad = 0;
+        emit_record(&rec.hdr, EMIT_DOP, sizeof(rec));
+    }
     pastef(dopwin, 1,  9, 3, "%4.1f", getleu16(buf, 12) / 100.0);
     pastef(dopwin, 1, 18, 3, "%4.1f", getleu16(buf, 10) / 100.0);
     pastef(dopwin, 1, 27, 3, "%4.1f", getleu16(buf,  6) / 100.0);
@@ -168,14 +298,531 @@ static void display_nav_dop(unsigned char *buf, size_t data_len)
 }
 
 
+// UBX-NAV-TIMELS: current leap second count, when flagged valid
+static void decode_nav_timels(unsigned char *buf, size_t data_len)
+{
+    if (24 != data_len ||
+        0 == (getub(buf, 23) & 0x01)) {
+        return;
+    }
+    leap_seconds = getsb(buf, 9);
+    leap_valid = true;
+    leap_timels = true;
+}
+
+/* UBX-NAV-TIMEUTC: leap seconds are GPS time minus the UTC it reports,
+ * both to the ms.  The week is that of the last NAV-SOL, so an iTOW
+ * below its own is in the next week and skipped. */
+static void decode_nav_timeutc(unsigned char *buf, size_t data_len)
+{
+    unsigned valid;
+    unsigned long itow;
+    int year, month, day;
+    long long era, yoe, doy, doe, utc, gps_ms, utc_ms;
+
+    if (20 != data_len ||
+        0 > last_week ||
+        leap_timels) {
+        return;
+    }
+    itow = getleu32(buf, 0);
+    if (itow < last_tow) {
+        return;
+    }
+    valid = getub(buf, 19);
+    if (0x07 != (valid & 0x07)) {       // validTOW, validWKN, validUTC
+        return;
+    }
+    year = getleu16(buf, 12);
+    month = getub(buf, 14);
+    day = getub(buf, 15);
+
+    // days from civil, proleptic Gregorian
+    year -= (2 >= month);
+    era = year / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month + (2 < month ? -3 : 9)) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    utc = (era * 146097 + doe - 719468) * 86400 +
+          getub(buf, 16) * 3600 + getub(buf, 17) * 60 + getub(buf, 18);
+    utc_ms = utc * 1000 + getles32(buf, 8) / 1000000;
+    gps_ms = (GPS_UNIX_EPOCH + (long long)last_week * 604800) * 1000 +
+             (long long)itow;
+    leap_seconds = (int)lround((double)(gps_ms - utc_ms) / 1000.0);
+    leap_valid = true;
+}
+
+/* GPS week, time of week (ms) and its ns fraction to a binary timestamptz
+ * (microseconds since 2000-01-01 UTC).  Without NAV-TIMELS/NAV-TIMEUTC
+ * the leap seconds known to the gpsd context are used. */
+static int64_t gps_to_pg_usec(unsigned week, unsigned long tow, long ftow)
+{
+    int leap = leap_valid ? leap_seconds : session.context->leap_seconds;
+
+    return GPS_PG_EPOCH_USEC +
+           ((int64_t)week * 604800 - leap) * 1000000 +
+           (int64_t)tow * 1000 + ftow / 1000;
+}
+
+/* The same to a UTC timespec, keeping the ns; with utc the week and
+ * time of week already count UTC, as TIM messages may. */
+static void gps_to_timespec(unsigned week, unsigned long tow, long ns,
+                            bool utc, timespec_t *ts)
+{
+    int leap = leap_valid ? leap_seconds : session.context->leap_seconds;
+
+    ts->tv_sec = (time_t)(GPS_UNIX_EPOCH + (long long)week * 604800 +
+                          (long long)(tow / 1000) - (utc ? 0 : leap));
+    ts->tv_nsec = (long)(tow % 1000) * 1000000 + ns;
+    TS_NORM(ts);
+}
+
+// one epoch of satellites, NAV-SAT or NAV-SVINFO alike
+static struct sky_epoch_t sky;
+// NAV-SAT seen: it supersedes NAV-SVINFO
+static bool have_nav_sat;
+
+/* The epoch in sky to the pass tracker and the raw sky rows.  The GPS
+ * week is that of the last NAV-SOL, which the receiver sends ahead of
+ * the satellites.  An epoch already stored is not stored again: the
+ * first NAV-SAT may follow a NAV-SVINFO of the same iTOW. */
+static void store_sky(unsigned long tow)
+{
+    static bool stored;
+
+    if (stored &&
+        tow == sky.tow) {
+        return;
+    }
+    stored = true;
+    sky.tow = tow;
+    if (0 <= last_week) {
+        gps_to_timespec((unsigned)last_week, tow, 0, false, &sky.time);
+    } else {
+        sky.time.tv_sec = 0;
+        sky.time.tv_nsec = 0;
+    }
+    passes_epoch(&sky);
+    sky_epoch(&sky, &burst_time);
+}
+
+static void store_nav_sat(unsigned char *buf, size_t data_len)
+{
+    unsigned fl, off;
+    int i, nchan;
+
+    if (8 > data_len) {
+        return;
+    }
+    nchan = getub(buf, 5);
+    sky.n = 0;
+    for (i = 0; i < nchan && i < SKY_MAXSV; i++) {
+        off = 8 + 12 * i;
+        if (off + 12 > data_len) {
+            break;
+        }
+        fl = getleu16(buf, off + 8);
+        sky.gnss[i] = (int16_t)getub(buf, off);
+        sky.sv[i] = (int16_t)getub(buf, off + 1);
+        sky.prn[i] = (int16_t)gnssid_prn(getub(buf, off),
+                                         getub(buf, off + 1));
+        sky.ss[i] = (int16_t)getub(buf, off + 2);
+        sky.el[i] = (int16_t)getsb(buf, off + 3);
+        sky.az[i] = (int16_t)getles16(buf, off + 4);
+        sky.fl[i] = (int16_t)fl;
+        sky.used[i] = 0 != (fl & (UBX_SAT_USED << 3));
+        sky.n++;
+    }
+    store_sky(getleu32(buf, 0));
+}
+
+/* NAV-SVINFO of receivers without NAV-SAT: the PRN back to gnssId and
+ * svId, the flags to their NAV-SAT equivalent. */
+static void store_nav_svinfo(unsigned char *buf, size_t data_len)
+{
+    unsigned flags, gnss, health, off, orbit, sv;
+    int i, nchan;
+
+    if (8 > data_len ||
+        have_nav_sat) {
+        return;
+    }
+    nchan = getub(buf, 4);
+    sky.n = 0;
+    for (i = 0; i < nchan && sky.n < SKY_MAXSV; i++) {
+        off = 8 + 12 * i;
+        if (off + 12 > data_len) {
+            break;
+        }
+        if (!gnssid_native(getub(buf, off + 1), &gnss, &sv)) {
+            continue;
+        }
+        flags = getub(buf, off + 2);
+        if (0 != (flags & UBX_SAT_EPHEM)) {
+            orbit = 1;                  // ephemeris
+        } else if (0 != (flags & 0x20)) {
+            orbit = 2;                  // almanac
+        } else if (0 != (flags & 0x40)) {   // orbitAop
+            orbit = 4;                  // AssistNow Autonomous orbit
+        } else if (0 != (flags & UBX_SAT_EPHALM)) {
+            orbit = 7;                  // other
+        } else {
+            orbit = 0;
+        }
+        health = 0 != (flags & UBX_SAT_UNHEALTHY) ? 2 : 1;
+        sky.gnss[sky.n] = (int16_t)gnss;
+        sky.sv[sky.n] = (int16_t)sv;
+        sky.prn[sky.n] = (int16_t)getub(buf, off + 1);
+        sky.ss[sky.n] = (int16_t)getub(buf, off + 4);
+        sky.el[sky.n] = (int16_t)getsb(buf, off + 5);
+        sky.az[sky.n] = (int16_t)getles16(buf, off + 6);
+        // quality, used, health, diffCorr, smoothed (same bit), orbit
+        sky.fl[sky.n] = (int16_t)((getub(buf, off + 3) & 0x07) |
+                                  (flags & UBX_SAT_USED) << 3 |
+                                  health << 4 |
+                                  (flags & UBX_SAT_DGPS) << 5 |
+                                  (flags & 0x80) |
+                                  orbit << 8);
+        sky.used[sky.n] = 0 != (flags & UBX_SAT_USED);
+        sky.n++;
+    }
+    store_sky(getleu32(buf, 0));
+}
+
+// I/Q magnitudes of the last MON-HW2, for the next MON-HW sample
+static int hw2_magi = -1, hw2_magq = -1;
+// MON-RF seen: it supersedes MON-HW
+static bool have_mon_rf;
+
+// UBX-MON-RF: one sample per RF block
+static void decode_mon_rf(unsigned char *buf, size_t data_len)
+{
+    unsigned i, nblocks;
+
+    nblocks = getub(buf, 1);
+    if (4 + nblocks * 24 != data_len) {
+        return;
+    }
+    have_mon_rf = true;
+    for (i = 0; i < nblocks; i++) {
+        unsigned char *blk = buf + 4 + i * 24;
+        int v[RFMON_FIELDS];
+
+        v[RFMON_NOISE] = getleu16(blk, 12);
+        v[RFMON_AGC] = getleu16(blk, 14);
+        v[RFMON_JAM] = getub(blk, 16);
+        v[RFMON_JAMSTATE] = getub(blk, 1) & 0x03;
+        v[RFMON_ANT] = getub(blk, 2);
+        v[RFMON_ANTPOWER] = getub(blk, 3);
+        v[RFMON_MAGI] = getub(blk, 18);
+        v[RFMON_MAGQ] = getub(blk, 20);
+        rfmon_sample(getub(blk, 0), v, &session.lexer.pkt_time);
+    }
+}
+
+// UBX-MON-HW, before MON-RF existed: block 0 only
+static void decode_mon_hw(unsigned char *buf, size_t data_len)
+{
+    int v[RFMON_FIELDS];
+
+    if (60 != data_len ||
+        have_mon_rf) {
+        return;
+    }
+    v[RFMON_NOISE] = getleu16(buf, 16);
+    v[RFMON_AGC] = getleu16(buf, 18);
+    v[RFMON_JAM] = getub(buf, 45);
+    v[RFMON_JAMSTATE] = (getub(buf, 22) >> 2) & 0x03;
+    v[RFMON_ANT] = getub(buf, 20);
+    v[RFMON_ANTPOWER] = getub(buf, 21);
+    v[RFMON_MAGI] = hw2_magi;
+    v[RFMON_MAGQ] = hw2_magq;
+    rfmon_sample(0, v, &session.lexer.pkt_time);
+}
+
+// UBX-MON-HW2: only the I/Q magnitudes are kept
+static void decode_mon_hw2(unsigned char *buf, size_t data_len)
+{
+    if (28 != data_len) {
+        return;
+    }
+    hw2_magi = getub(buf, 1);
+    hw2_magq = getub(buf, 3);
+}
+
+// UBX-MON-TXBUF (u-blox 8): total peak, any limit or allocation error
+static void decode_mon_txbuf(unsigned char *buf, size_t data_len)
+{
+    if (28 != data_len) {
+        return;
+    }
+    txmon_receiver(getub(buf, 25), 0 != getub(buf, 26));
+}
+
+// UBX-MON-COMMS (u-blox 9): busiest port, memory or allocation error
+static void decode_mon_comms(unsigned char *buf, size_t data_len)
+{
+    unsigned i, nports, peak = 0;
+
+    nports = getub(buf, 1);
+    if (8 + nports * 40 != data_len) {
+        return;
+    }
+    for (i = 0; i < nports; i++) {
+        unsigned p = getub(buf, 8 + i * 40 + 9);       // txPeakUsage
+
+        if (p > peak) {
+            peak = p;
+        }
+    }
+    txmon_receiver(peak, 0 != (getub(buf, 2) & 0x03));
+}
+
+/* UBX-TIM-TP: the next time pulse.  Only GPS and UTC time bases, the
+ * other GNSS count weeks from their own epochs. */
+static void decode_tim_tp(unsigned char *buf, size_t data_len)
+{
+    unsigned flags;
+    bool utc;
+    timespec_t pulse;
+
+    if (16 != data_len) {
+        return;
+    }
+    flags = getub(buf, 14);
+    utc = 0 != (flags & 0x01);
+    if (!utc &&
+        0 != (getub(buf, 15) & 0x0f)) {
+        return;
+    }
+    // towSubMS is in 2^-32 ms
+    gps_to_timespec(getleu16(buf, 12), getleu32(buf, 0),
+                    (long)(((uint64_t)getleu32(buf, 4) * 1000000) >> 32),
+                    utc, &pulse);
+    timing_tp(&pulse, getles32(buf, 8), 0 == (flags & 0x10),
+              &session.lexer.pkt_time);
+}
+
+// UBX-TIM-TM2: an EXTINT event, when the receiver has a new edge
+static void decode_tim_tm2(unsigned char *buf, size_t data_len)
+{
+    unsigned flags;
+    timespec_t rise, fall;
+
+    if (28 != data_len) {
+        return;
+    }
+    flags = getub(buf, 1);
+    if (0 == (flags & 0x40) ||                  // timeValid
+        0 == (flags & 0x84)) {                  // newRisingEdge, newFallingEdge
+        return;
+    }
+    /* timeBase: only UTC is a known scale; receiver time (0) is no scale
+     * and GNSS time (1) is whichever system CFG-TP5 chose */
+    if (2 != ((flags >> 3) & 0x03)) {
+        return;
+    }
+    gps_to_timespec(getleu16(buf, 4), getleu32(buf, 8),
+                    (long)getleu32(buf, 12), true, &rise);
+    gps_to_timespec(getleu16(buf, 6), getleu32(buf, 16),
+                    (long)getleu32(buf, 20), true, &fall);
+    timing_tm2(getub(buf, 0), getleu16(buf, 2),
+               0 != (flags & 0x80) ? &rise : NULL,
+               0 != (flags & 0x04) ? &fall : NULL,
+               getleu32(buf, 24));
+}
+
+/* console line of a NAV-SOL epoch, and with VERB_SQL the stored row,
+ * built in one buffer and written with one write() */
+static void print_nav_sol(const struct gps_data_t *g, gps_mask_t outmask,
+                          const double *enu, double epx, double epz,
+                          double evx, double evy, double evz,
+                          unsigned tow, unsigned short gw,
+                          unsigned flags, unsigned char navmode)
+{
+    uint64_t tod = tow / 1000UL;              // remove ms
+    unsigned s = (unsigned)(tod % 60);
+    unsigned m = (unsigned)((tod % 3600UL) / 60);
+    unsigned h = (unsigned)((tod / 3600UL) % 24);
+    unsigned day = (unsigned)(tod / 86400UL);
+
+    lb_str(&line, "epx ");
+    lb_fixed(&line, epx, 10, 2, true);
+    lb_str(&line, " epz ");
+    lb_fixed(&line, epz, 10, 2, true);
+    lb_str(&line, " evx ");
+    lb_fixed(&line, evx, 9, 2, true);
+    lb_str(&line, " evy ");
+    lb_fixed(&line, evy, 9, 2, true);
+    lb_str(&line, " evz ");
+    lb_fixed(&line, evz, 9, 2, true);
+    lb_char(&line, ' ');
+
+    if (0 != (outmask & LATLON_SET)) {
+        lb_str(&line, "φ ");
+        lb_fixed(&line, g->fix.latitude, 12, 9, false);
+        lb_str(&line, "  λ ");
+        lb_fixed(&line, g->fix.longitude, 13, 9, false);
+        lb_str(&line, "  h ");
+        lb_fixed(&line, g->fix.altHAE, 8, 2, false);
+        lb_str(&line, "m ");
+    }
+
+    if (NULL != enu) {
+        lb_str(&line, "ΔE ");
+        lb_fixed(&line, enu[0], 8, 3, true);
+        lb_str(&line, " ΔN ");
+        lb_fixed(&line, enu[1], 8, 3, true);
+        lb_str(&line, " ΔU ");
+        lb_fixed(&line, enu[2], 8, 3, true);
+        lb_char(&line, ' ');
+    }
+
+    // coverity says g->fix.track never set.
+    if (0 != (outmask & VNED_SET)) {
+        lb_fixed(&line, g->fix.speed, 6, 2, false);
+        lb_str(&line, "m/s ");
+        lb_fixed(&line, NAN, 5, 1, false);
+        lb_str(&line, "o ");
+        lb_fixed(&line, g->fix.climb, 6, 2, false);
+        lb_str(&line, "m/s ");
+    }
+
+    lb_str(&line, "Дата ");
+    lb_long(&line, (long)day, 0, false);
+    lb_char(&line, ' ');
+    lb_long(&line, (long)h, 2, true);
+    lb_char(&line, ':');
+    lb_long(&line, (long)m, 2, true);
+    lb_char(&line, ':');
+    lb_long(&line, (long)s, 2, true);
+    lb_char(&line, '.');
+    lb_long(&line, (long)((tow % 1000) / 10), 2, true);
+    lb_char(&line, ' ');
+    if ((flags & (UBX_SOL_VALID_WEEK | UBX_SOL_VALID_TIME)) != 0) {
+        lb_long(&line, gw, 0, false);
+        lb_char(&line, '+');
+        lb_fixed(&line, (double)(tow / 1000.0), 10, 3, false);
+        lb_str(&line, " tow ");
+        lb_long(&line, (long)(tow / 86400000), 0, false);
+    }
+
+    // relies on the fact that epx and epy are set to same value
+    lb_fixed(&line, g->fix.epx, 7, 2, false);
+    lb_str(&line, " epx ");
+    lb_fixed(&line, g->fix.epv, 6, 2, false);
+    lb_str(&line, " epv ");
+    lb_long(&line, g->satellites_used, 2, false);
+    lb_str(&line, " sputn ");
+    lb_fixed(&line, g->dop.pdop, 5, 1, false);
+    lb_str(&line, " pdop 0x");
+    lb_hex(&line, navmode, 2);
+    lb_str(&line, " navmod 0x");
+    lb_hex(&line, flags, 2);
+    lb_str(&line, " flag\r\n");
+
+    if (VERB_SQL > verbosity) {
+        lb_write(&line, STDOUT_FILENO);
+        return;
+    }
+
+    // echo of the stored row
+    lb_str(&line, "SQL\n(");
+    lb_long(&line, pgsink_series_id(), 0, false);
+    lb_str(&line, ", '");
+    lb_fixed(&line, g->fix.latitude, 12, 9, false);
+    lb_str(&line, "', '");
+    lb_fixed(&line, g->fix.longitude, 13, 9, false);
+    lb_str(&line, "', '");
+    lb_fixed(&line, g->fix.altHAE, 8, 2, false);
+    lb_str(&line, "', '");
+    lb_fixed(&line, epx, 10, 2, true);
+    lb_str(&line, "', '");
+    lb_fixed(&line, epz, 10, 2, true);
+    lb_str(&line, "', '");
+    lb_fixed(&line, evx, 9, 2, true);
+    lb_str(&line, "', '");
+    lb_fixed(&line, evy, 9, 2, true);
+    lb_str(&line, "', '");
+    lb_fixed(&line, evz, 9, 2, true);
+    lb_str(&line, "', '");
+    lb_fixed(&line, g->fix.speed, 6, 2, false);
+    lb_str(&line, "', '");
+    lb_fixed(&line, g->fix.climb, 6, 2, false);
+    lb_str(&line, "', ");
+    lb_long(&line, (long)day, 0, false);
+    lb_str(&line, ", '");
+    lb_long(&line, (long)h, 2, true);
+    lb_char(&line, ':');
+    lb_long(&line, (long)m, 2, true);
+    lb_char(&line, ':');
+    lb_long(&line, (long)s, 2, true);
+    lb_char(&line, '.');
+    lb_long(&line, (long)((tow % 1000) / 10), 2, true);
+    lb_str(&line, "', '");
+    lb_fixed(&line, g->fix.epx, 7, 2, false);
+    lb_str(&line, "', '");
+    lb_fixed(&line, g->fix.epv, 6, 2, false);
+    lb_str(&line, "', ");
+    lb_long(&line, g->satellites_used, 0, false);
+    lb_str(&line, ", '");
+    lb_fixed(&line, g->dop.pdop, 5, 1, false);
+    lb_str(&line, "', ");
+    lb_long(&line, navmode, 0, false);
+    lb_str(&line, ", '");
+    lb_hex(&line, flags, 2);
+    lb_str(&line, "')\n");
+    lb_write(&line, STDOUT_FILENO);
+}
+
+/* Store the receive time of the epoch's burst, and the PPS edge it
+ * belongs to: the last one before the burst and less than a second
+ * ahead of it, and only for epochs on a whole second, as the pulse
+ * marks only those.  pps_thread_ppsout() is a copy under an uncontended
+ * mutex, no system call. */
+static void copy_epoch_times(unsigned int tow)
+{
+    struct timedelta_t pps;
+    timespec_t lag;
+
+    if (0 == burst_time.tv_sec) {
+        // replay: no host time
+        pgcopy_null(fixcopy);
+        pgcopy_null(fixcopy);
+        return;
+    }
+    if (serial &&
+        0 == tow % 1000 &&
+        0 < pps_thread_ppsout(&session.pps_thread, &pps)) {
+        TS_SUB(&lag, &burst_time, &pps.clock);
+    } else {
+        lag.tv_sec = -1;
+    }
+    if (0 == lag.tv_sec &&
+        0 <= lag.tv_nsec) {
+        pgcopy_timespec(fixcopy, &pps.clock);
+    } else {
+        pgcopy_null(fixcopy);
+    }
+    pgcopy_timespec(fixcopy, &burst_time);
+}
+
 static void display_nav_sol(unsigned char *buf, size_t data_len)
 {
     gps_mask_t outmask;
     unsigned short gw = 0;
     unsigned int tow = 0, flags;
+    long ftow = 0;
+    bool timed;
+    int64_t pg_usec = 0;
     double epx, epy, epz, evx, evy, evz;
+    double ecef[3], enu[3];
     unsigned char navmode;
     struct gps_data_t g;
+    int gate;
+    uint64_t tod;
+    unsigned day;
+    char flg[3];
 
     if (52 != data_len) {
         return;
@@ -183,13 +830,23 @@ static void display_nav_sol(unsigned char *buf, size_t data_len)
     // pacify coverity
     memset(&g, 0, sizeof(g));
 
-navmode = (unsigned char)getub(buf, 10);
+    navmode = (unsigned char)getub(buf, 10);
     flags = (unsigned int)getub(buf, 11);
 
     if ((flags & (UBX_SOL_VALID_WEEK | UBX_SOL_VALID_TIME)) != 0) {
         tow = (unsigned int)getleu32(buf, 0);
         gw = (unsigned short)getles16(buf, 8);
     }
+    timed = (UBX_SOL_VALID_WEEK | UBX_SOL_VALID_TIME) ==
+            (flags & (UBX_SOL_VALID_WEEK | UBX_SOL_VALID_TIME));
+    if (timed) {
+        ftow = getles32(buf, 4);
+        last_week = gw;
+        last_tow = tow;
+        pg_usec = gps_to_pg_usec(gw, tow, ftow);
+    }
+    tod = tow / 1000UL;              // remove ms
+    day = (unsigned)(tod / 86400UL);
 
     epx = (double)(getles32(buf, 12) / 100.0);
     epy = (double)(getles32(buf, 16) / 100.0);
@@ -197,110 +854,247 @@ navmode = (unsigned char)getub(buf, 10);
     evx = (double)(getles32(buf, 28) / 100.0);
     evy = (double)(getles32(buf, 32) / 100.0);
     evz = (double)(getles32(buf, 36) / 100.0);
-    outmask = ecef_to_wgs84fix(&g.fix, epx, epy, epz, evx, evy, evz);
+    outmask = 0;
+    if (0.0 != epx ||
+        0.0 != epy ||
+        0.0 != epz) {
+        const double vel[3] = {evx, evy, evz};
+        struct geo_enu_t local;
+        double venu[3];
+
+        // closed form, no need for the general ecef_to_wgs84fix()
+        geo_ecef_to_llh(epx, epy, epz, &g.fix.latitude, &g.fix.longitude,
+                        &g.fix.altHAE);
+        geo_enu_init(&local, g.fix.latitude, g.fix.longitude, g.fix.altHAE);
+        geo_enu_rotate(&local, vel, venu);
+        g.fix.speed = sqrt(venu[0] * venu[0] + venu[1] * venu[1]);
+        g.fix.climb = venu[2];
+        outmask = LATLON_SET | ALTITUDE_SET | VNED_SET;
+    }
+    ecef[0] = epx;
+    ecef[1] = epy;
+    ecef[2] = epz;
 
     g.fix.epx = g.fix.epy = (double)(getles32(buf, 24) / 100.0);
     g.fix.eps = (double)(getles32(buf, 40) / 100.0);
     g.dop.pdop = (double)(getleu16(buf, 44) / 100.0);
     g.satellites_used = (int)getub(buf, 47);
 
-    printf( "epx %+10.2f epz %+10.2f evx %+9.2f evy %+9.2f evz %+9.2f ", epx, epz, evx, evy, evz);
-
-    if (0 != (outmask & LATLON_SET)) {
-        printf("φ %12.9f  λ %13.9f  h %8.2fm ",
-                  g.fix.latitude, g.fix.longitude, g.fix.altHAE);
+    if (0 == (outmask & LATLON_SET)) {
+        g.fix.latitude = NAN;
+        g.fix.longitude = NAN;
+        g.fix.altHAE = NAN;
     }
-  
     // coverity says g.fix.track never set.
-    if (0 != (outmask & VNED_SET)) {
-        printf("%6.2fm/s %5.1fo %6.2fm/s ",
-                  g.fix.speed, NAN, g.fix.climb);
+    if (0 == (outmask & VNED_SET)) {
+        g.fix.speed = NAN;
+        g.fix.climb = NAN;
     }
 
+    if (have_reference &&
+        0 != (outmask & LATLON_SET)) {
+        // one subtraction and one 3x3 multiply per fix
+        geo_enu(&reference, ecef, enu);
+    } else {
+        enu[0] = enu[1] = enu[2] = NAN;
+    }
 
-    {
-        uint64_t tod = tow / 1000UL;              // remove ms
-        unsigned s = (unsigned)(tod % 60);
-        unsigned m = (unsigned)((tod % 3600UL) / 60);
-        unsigned h = (unsigned)((tod / 3600UL) % 24);
-        unsigned day = (unsigned)(tod / 86400UL);
+    gate = qgate_check(navmode, flags, g.satellites_used, g.dop.pdop,
+                       g.fix.epx, 0 != (outmask & LATLON_SET) ? ecef : NULL);
+    if (QGATE_OK == gate) {
+        posstats_fix(ecef, g.fix.latitude, g.fix.longitude, g.fix.altHAE);
+        if (timed) {
+            rollup_fix(pg_usec, ecef, g.fix.latitude, g.fix.longitude,
+                       g.fix.altHAE, g.satellites_used, g.dop.pdop);
+        }
+    } else {
+        posstats_rejected();
+    }
 
-        printf ("Дата %u %02u:%02u:%02d.%02d ",
-                        day, h, m, s, (tow % 1000)  / 10);    
+    if (VERB_FIX <= verbosity) {
+        print_nav_sol(&g, outmask, have_reference ? enu : NULL,
+                      epx, epz, evx, evy, evz,
+                      tow, gw, flags, navmode);
     }
-    if ((flags & (UBX_SOL_VALID_WEEK | UBX_SOL_VALID_TIME)) != 0) {
-        printf ("%d+%10.3lf tow %d", gw, (double)(tow / 1000.0), (tow / 86400000));
+
+    if (emit_binary()) {
+        struct emit_fix_t rec;
+
+        rec.tow = tow;
+        rec.time = timed ? pg_usec + PG_UNIX_EPOCH_USEC
+                         : INT64_MIN;
+        rec.lat = g.fix.latitude;
+        rec.lon = g.fix.longitude;
+        rec.alt = g.fix.altHAE;
+        rec.ecef[0] = epx;
+        rec.ecef[1] = epy;
+        rec.ecef[2] = epz;
+        rec.vel[0] = evx;
+        rec.vel[1] = evy;
+        rec.vel[2] = evz;
+        rec.speed = g.fix.speed;
+        rec.climb = g.fix.climb;
+        rec.eph = g.fix.epx;
+        rec.epv = g.fix.epv;
+        rec.pdop = g.dop.pdop;
+        rec.week = gw;
+        rec.sats = (uint8_t)g.satellites_used;
+        rec.navmode = navmode;
+        rec.flags = (uint8_t)flags;
+        memset(rec.pad, 0, sizeof(rec.pad));
+        emit_record(&rec.hdr, EMIT_FIX, sizeof(rec));
     }
 
-    // relies on the fact that epx and epy are set to same value
-    printf ("%7.2f epx %6.2f epv %2d sputn %5.1f pdop 0x%02x navmod 0x%02x flag", g.fix.epx, g.fix.epv, g.satellites_used, g.dop.pdop, navmode, flags);
-    
-    printf("\r\n");
-    
-    {
-    
-	char			   *conninfo = NULL;
-	char			   *seria = "?";
-	PGconn			   *conn;
-	PGresult		   *res;
-	int					nFields;
-	int					i,
-						j;
-    uint64_t tod = tow / 1000UL;              // remove ms
-        unsigned s = (unsigned)(tod % 60);
-        unsigned m = (unsigned)((tod % 3600UL) / 60);
-        unsigned h = (unsigned)((tod / 3600UL) % 24);
-        unsigned day = (unsigned)(tod / 86400UL);						
-	char stmt[512]; /* максимальная длина запроса */
-    if (0 == (outmask & LATLON_SET)) {
-                  g.fix.latitude = NAN;
-                  g.fix.longitude = NAN;
-                  g.fix.altHAE = NAN;
+    if (NULL == fixcopy &&
+        pgsink_active()) {
+        fixcopy = pgsink_stream("Измерения", "U-Blox", FIX_COLUMNS, true);
     }
- 
-    // coverity says g.fix.track never set.
-    if (0 == (outmask & VNED_SET)) {
-        g.fix.speed = NAN;
-        g.fix.climb = NAN;
-    }	
-	const char		   *query1 =
-		"INSERT INTO \"Измерения\".\"U-Blox\" (\"Серия\", φ, λ, h, epx, epz, evx, evy, evz, v, clm, \"День недели\", \"UTC\", epx1, epv, \"Спутников\", dop, \"Режим\", flg)"
-		" VALUES('%s', '%12.9f', '%13.9f', '%8.2f', '%+10.2f', '%+10.2f', '%+9.2f', '%+9.2f', '%+9.2f', '%6.2f', '%6.2f', %u, '%02u:%02u:%02d.%02d', '%7.2f', '%6.2f', %d, '%5.1f', %d, '%02x') RETURNING *;";
-	
-	seria = "ßßßß";	
-		conninfo = "dbname='Геоинформационная система' host=localhost port=5432 connect_timeout=10 password=111111";
-
-	/* Соединяемся с БД */
-	conn = PQconnectdb(conninfo);
-
-	/* Проверка провала соединения с БД */
-	if (PQstatus(conn) != CONNECTION_OK)
-	{
-		fprintf(stderr, "%s", PQerrorMessage(conn));
-		PQfinish(conn);
-	}
-	
-	sprintf(stmt, query1,
-        	seria, // Серия, φ, λ, h, 
-        	g.fix.latitude,
-        	g.fix.longitude,
-        	g.fix.altHAE,
-        	epx, epz, evx, evy, evz, //epx, epz, evx, evy, evz, v, clm, d, t, epx1, epv, sptn, dop, mode
-            g.fix.speed, g.fix.climb,
-            day, h, m, s,(tow % 1000)  / 10,
-            g.fix.epx, g.fix.epv,
-            g.satellites_used, g.dop.pdop, navmode, flags       	
-        );
-printf("SQL\n");
-printf(stmt);
-printf("\n");
-		/* Отправка текста запроса в БД */
-		res = PQexec(conn,stmt);
-		if(PQresultStatus(res) != PGRES_COMMAND_OK)
-			fprintf(stderr, "%s", PQerrorMessage(conn));
-
-
-	PQfinish(conn);
+    if (NULL == fixcopy ||
+        QGATE_OK != gate) {
+        return;
+    }
+    flg[0] = "0123456789abcdef"[(flags >> 4) & 0x0f];
+    flg[1] = "0123456789abcdef"[flags & 0x0f];
+    flg[2] = '\0';
+    pgcopy_row(fixcopy, FIX_FIELDS);
+    pgcopy_int4(fixcopy, pgsink_series_id());
+    pgcopy_float8(fixcopy, g.fix.latitude);
+    pgcopy_float8(fixcopy, g.fix.longitude);
+    pgcopy_float8(fixcopy, g.fix.altHAE);
+    pgcopy_float8(fixcopy, epx);
+    pgcopy_float8(fixcopy, epz);
+    pgcopy_float8(fixcopy, evx);
+    pgcopy_float8(fixcopy, evy);
+    pgcopy_float8(fixcopy, evz);
+    pgcopy_float8(fixcopy, g.fix.speed);
+    pgcopy_float8(fixcopy, g.fix.climb);
+    pgcopy_int2(fixcopy, (int)day);
+    pgcopy_time(fixcopy, (int64_t)(tod % 86400UL) * 1000000 +
+                         (int64_t)(tow % 1000) * 1000);
+    pgcopy_float8(fixcopy, g.fix.epx);
+    pgcopy_float8(fixcopy, g.fix.epv);
+    pgcopy_int2(fixcopy, g.satellites_used);
+    pgcopy_float8(fixcopy, g.dop.pdop);
+    pgcopy_int2(fixcopy, navmode);
+    pgcopy_text(fixcopy, flg);
+    if (timed) {
+        pgcopy_int8(fixcopy, pg_usec);
+    } else {
+        pgcopy_null(fixcopy);
+    }
+    if (have_reference) {
+        pgcopy_float8(fixcopy, enu[0]);
+        pgcopy_float8(fixcopy, enu[1]);
+        pgcopy_float8(fixcopy, enu[2]);
+    } else {
+        pgcopy_null(fixcopy);
+        pgcopy_null(fixcopy);
+        pgcopy_null(fixcopy);
+    }
+    copy_epoch_times(tow);
+    pgcopy_commit(fixcopy);
+}
+
+// set the nominal point, "LAT,LON,H" or "ecef:X,Y,Z"
+bool ubx_reference(const char *spec)
+{
+    have_reference = geo_enu_parse(&reference, spec);
+    return have_reference;
+}
+
+// -c: measurement period in ms, programmed with the profile above
+bool ubx_profile(const char *spec)
+{
+    char *end;
+    unsigned long ms = strtoul(spec, &end, 10);
+
+    if (end == spec ||
+        '\0' != *end ||
+        25 > ms ||
+        65535 < ms) {
+        return false;
+    }
+    profile_ms = (unsigned)ms;
+    return true;
+}
+
+/* Send the profile once, on the first UBX packet, so that the device is
+ * known to be a UBX receiver on a port we can write to.  The commands go
+ * out back to back, without waiting for their acknowledgements. */
+static void ubx_send_profile(void)
+{
+    unsigned char msg[8];
+    unsigned i, failed = 0;
+
+    profile_sent = true;
+    for (i = 0; i < sizeof(profile) / sizeof(profile[0]); i++) {
+        msg[0] = UBX_CLASS_CFG;
+        msg[1] = UBX_CFG_MSG & 0xff;
+        msg[2] = (unsigned char)(profile[i].msgid >> 8);
+        msg[3] = (unsigned char)(profile[i].msgid & 0xff);
+        msg[4] = profile[i].rate;
+        if (!monitor_control_send(msg, 5)) {
+            failed++;
+        } else {
+            asked.msgid[asked.n++] = profile[i].msgid;
+        }
+    }
+
+    // CFG-RATE: measRate, navRate 1, timeRef 1 (GPS time)
+    msg[0] = UBX_CLASS_CFG;
+    msg[1] = UBX_CFG_RATE & 0xff;
+    putle16(msg, 2, profile_ms);
+    putle16(msg, 4, 1);
+    putle16(msg, 6, 1);
+    if (!monitor_control_send(msg, 8)) {
+        failed++;
+    }
+    if (0 != failed) {
+        (void)fprintf(stderr, "gpsmon: %u of %u profile commands not sent\n",
+                      failed,
+                      (unsigned)(sizeof(profile) / sizeof(profile[0])) + 1);
+    }
+}
+
+/* The first NAV-SAT: from now on NAV-SVINFO is ignored, and if -c
+ * enabled it, turned off.  Receivers without NAV-SAT keep it. */
+static void nav_sat_seen(void)
+{
+    unsigned char msg[5] = {UBX_CLASS_CFG, UBX_CFG_MSG & 0xff,
+                            UBX_NAV_SVINFO >> 8, UBX_NAV_SVINFO & 0xff, 0};
+
+    have_nav_sat = true;
+    if (!profile_sent) {
+        return;
+    }
+    if (!monitor_control_send(msg, sizeof(msg))) {
+        (void)fputs("gpsmon: NAV-SVINFO not turned off\n", stderr);
+    } else {
+        asked.msgid[asked.n++] = UBX_NAV_SVINFO;
+    }
+}
+
+/* ACK-ACK or ACK-NAK of a -c command: a refused one leaves the profile
+ * only partly applied, say which. */
+static void profile_answer(unsigned msgid, bool ack)
+{
+    unsigned id;
+
+    if (UBX_CFG_RATE == msgid &&
+        profile_sent &&
+        !ack) {
+        (void)fputs("gpsmon: CFG-RATE refused, measurement period "
+                    "unchanged\n", stderr);
+        return;
+    }
+    if (UBX_CFG_MSG != msgid ||
+        asked.answered >= asked.n) {
+        return;
+    }
+    id = asked.msgid[asked.answered++];
+    if (!ack) {
+        (void)fprintf(stderr, "gpsmon: CFG-MSG for class 0x%02x id 0x%02x "
+                      "refused\n", id >> 8, id & 0xff);
     }
 }
 
@@ -313,12 +1107,42 @@ static void ubx_update(void)
     buf = session.lexer.outbuffer;
     msgid = (unsigned short)((buf[2] << 8) | buf[3]);
     data_len = (size_t) getles16(buf, 4);
+    if (0 != profile_ms &&
+        !profile_sent) {
+        ubx_send_profile();
+    }
+    ubxlink_start();
+    if (UBX_CLASS_NAV == buf[2] &&
+        4 <= data_len) {
+        unsigned long itow = getleu32(buf, 6);
+
+        if (itow != burst_tow) {
+            burst_tow = itow;
+            burst_time = session.lexer.pkt_time;
+        }
+    }
     switch (msgid) {
+    case UBX_ACK_ACK:
+    case UBX_ACK_NAK:
+        if (2 <= data_len) {
+            ubxlink_ack(UBX_MSGID(buf[6], buf[7]), UBX_ACK_ACK == msgid);
+            profile_answer(UBX_MSGID(buf[6], buf[7]), UBX_ACK_ACK == msgid);
+        }
+        break;
     case UBX_NAV_SVINFO:
         display_nav_svinfo(&buf[6], data_len);
+        if (pgsink_active()) {
+            store_nav_svinfo(&buf[6], data_len);
+        }
         break;
     case UBX_NAV_SAT:
+        if (!have_nav_sat) {
+            nav_sat_seen();
+        }
         display_nav_sat(&buf[6], data_len);
+        if (pgsink_active()) {
+            store_nav_sat(&buf[6], data_len);
+        }
         break;
     case UBX_NAV_DOP:
         display_nav_dop(&buf[6], data_len);
@@ -326,6 +1150,33 @@ static void ubx_update(void)
     case UBX_NAV_SOL:
         display_nav_sol(&buf[6], data_len);
         break;
+    case UBX_NAV_TIMELS:
+        decode_nav_timels(&buf[6], data_len);
+        break;
+    case UBX_NAV_TIMEUTC:
+        decode_nav_timeutc(&buf[6], data_len);
+        break;
+    case UBX_MON_RF:
+        decode_mon_rf(&buf[6], data_len);
+        break;
+    case UBX_MON_HW:
+        decode_mon_hw(&buf[6], data_len);
+        break;
+    case UBX_MON_HW2:
+        decode_mon_hw2(&buf[6], data_len);
+        break;
+    case UBX_MON_TXBUF:
+        decode_mon_txbuf(&buf[6], data_len);
+        break;
+    case UBX_MON_COMMS:
+        decode_mon_comms(&buf[6], data_len);
+        break;
+    case UBX_TIM_TP:
+        decode_tim_tp(&buf[6], data_len);
+        break;
+    case UBX_TIM_TM2:
+        decode_tim_tm2(&buf[6], data_len);
+        break;
     default:
         break;
     }
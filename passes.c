@@ -0,0 +1,169 @@
+/*
+ * Satellite pass tracker.
+ *
+ * Queries on the sky mostly ask when each satellite rose and set, how
+ * high it got and how well it was received.  This keeps the answer up
+ * to date from the NAV-SAT epochs, NAV-SVINFO on older receivers,
+ * instead of storing them: one pass per satellite in a fixed table
+ * indexed by gnssId and svId, so an epoch costs one lookup per
+ * satellite and a scan of the open passes.
+ *
+ * A satellite with a known orbit at or above PASSES_MIN_EL opens a pass
+ * or extends its open one.  A pass not extended for PASSES_GAP_SEC is
+ * over: it becomes one row of "Измерения"."U-Blox-проходы" from its
+ * rise to the last epoch it was seen, and the slot is free again.  The
+ * gap bridges short losses behind obstacles without splitting a pass.
+ * Passes still open at exit are written as not finished.
+ *
+ * Times are the epoch's GPS time in UTC, so replayed files give the
+ * same passes as the live receiver.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "include/passes.h"
+#include "include/pgsink.h"
+
+#define PASSES_COLUMNS "\"Серия\", \"Система\", \"Номер\", prn, " \
+                       "\"Восход\", \"Заход\", \"Азимут восхода\", " \
+                       "\"Азимут захода\", \"Наибольший угол\", " \
+                       "\"Момент наибольшего\", \"C/N0\", \"Эпох\", " \
+                       "\"В решении\", \"Закончен\""
+#define PASSES_FIELDS   14
+
+struct pass_t {
+    bool open;
+    int16_t prn;
+    struct timespec rise, last, top;    // first, last and highest epoch
+    int rise_az, last_az, top_el;
+    unsigned long epochs, used;         // epochs seen, used in the fix
+    unsigned long cno_sum, cno_n;       // over epochs with a signal
+};
+
+static struct pass_t table[GNSSID_N][256];
+static struct pass_t *open_passes[PASSES_MAXOPEN];
+static unsigned nopen;
+static struct pgcopy_t *passcopy;
+
+static void passes_copy(const struct pass_t *p, bool finished)
+{
+    // gnssId and svId are the place in the table
+    long i = (long)(p - &table[0][0]);
+
+    pgcopy_row(passcopy, PASSES_FIELDS);
+    pgcopy_int4(passcopy, pgsink_series_id());
+    pgcopy_int2(passcopy, (int)(i / 256));
+    pgcopy_int2(passcopy, (int)(i % 256));
+    pgcopy_int2(passcopy, p->prn);
+    pgcopy_timespec(passcopy, &p->rise);
+    pgcopy_timespec(passcopy, &p->last);
+    pgcopy_int2(passcopy, p->rise_az);
+    pgcopy_int2(passcopy, p->last_az);
+    pgcopy_int2(passcopy, p->top_el);
+    pgcopy_timespec(passcopy, &p->top);
+    if (0 < p->cno_n) {
+        pgcopy_float8(passcopy, (double)p->cno_sum / (double)p->cno_n);
+    } else {
+        pgcopy_null(passcopy);
+    }
+    pgcopy_int4(passcopy, (long)p->epochs);
+    pgcopy_int4(passcopy, (long)p->used);
+    pgcopy_bool(passcopy, finished);
+    pgcopy_commit(passcopy);
+}
+
+static void passes_final(bool final)
+{
+    unsigned i;
+
+    if (!final) {
+        return;
+    }
+    for (i = 0; i < nopen; i++) {
+        passes_copy(open_passes[i], false);
+        open_passes[i]->open = false;
+    }
+    nopen = 0;
+}
+
+// one epoch of satellites
+void passes_epoch(const struct sky_epoch_t *ep)
+{
+    unsigned i;
+
+    if (0 == ep->time.tv_sec) {
+        return;
+    }
+    if (NULL == passcopy) {
+        if (!pgsink_active()) {
+            return;
+        }
+        passcopy = pgsink_stream("Измерения", "U-Blox-проходы",
+                                 PASSES_COLUMNS, false);
+        if (NULL == passcopy) {
+            return;
+        }
+        pgsink_hook(passes_final);
+    }
+
+    for (i = 0; i < ep->n; i++) {
+        struct pass_t *p;
+
+        // svId 0 and 255 are GLONASS with the slot not yet known
+        if (GNSSID_N <= ep->gnss[i] ||
+            0 == ep->sv[i] ||
+            255 <= ep->sv[i] ||
+            PASSES_MIN_EL > ep->el[i] ||
+            0 == (ep->fl[i] & SKY_FL_ORBIT)) {
+            continue;
+        }
+        p = &table[ep->gnss[i]][ep->sv[i]];
+        if (!p->open) {
+            if (PASSES_MAXOPEN <= nopen) {
+                continue;
+            }
+            open_passes[nopen++] = p;
+            p->open = true;
+            p->rise = ep->time;
+            p->rise_az = ep->az[i];
+            p->top_el = -91;
+            p->epochs = p->used = 0;
+            p->cno_sum = p->cno_n = 0;
+        }
+        p->prn = ep->prn[i];
+        p->last = ep->time;
+        p->last_az = ep->az[i];
+        if (ep->el[i] > p->top_el) {
+            p->top_el = ep->el[i];
+            p->top = ep->time;
+        }
+        p->epochs++;
+        p->used += ep->used[i];
+        if (0 < ep->ss[i]) {
+            p->cno_sum += (unsigned long)ep->ss[i];
+            p->cno_n++;
+        }
+    }
+
+    // close what has not been seen for a while; the last open one moves in
+    for (i = 0; i < nopen; ) {
+        struct pass_t *p = open_passes[i];
+
+        if (PASSES_GAP_SEC < ep->time.tv_sec - p->last.tv_sec) {
+            passes_copy(p, true);
+            p->open = false;
+            open_passes[i] = open_passes[--nopen];
+        } else {
+            i++;
+        }
+    }
+}
+
+// vim: set expandtab shiftwidth=4
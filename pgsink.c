@@ -0,0 +1,616 @@
+/*
+ * Batched binary COPY of decoded UBX data into PostgreSQL.
+ *
+ * One connection is opened at startup and kept for the whole session.
+ * Each target table gets a pgcopy_t stream, tuples are encoded in the
+ * COPY binary format straight into the stream buffer and shipped as
+ * one COPY per batch.
+ *
+ * The series name is registered once at startup in "Измерения"."Серии",
+ * which hands out an integer key; rows carry only that key.  Partitioned
+ * targets are resolved to the leaf partition of the key once, when the
+ * stream is created, so the server never routes rows and the client
+ * never looks them up.
+ *
+ * The batch size of each stream is tuned AIMD style on the flush
+ * frequency.  A flush blocks the main loop for its round trip; when
+ * that takes more than PGSINK_DUTY_PCT of the time since the previous
+ * flush, or fails, the batch doubles.  Otherwise every flush that the
+ * batch size triggered shrinks it by one row, towards fresher data.  A
+ * flush forced by the age bound (-F) caps the batch at what arrived
+ * within the bound, so a slow link gets large COPYs and a local server
+ * gets a row at a time.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libpq-fe.h"
+
+#include "include/bits.h"
+#include "include/metrics.h"
+#include "include/pgsink.h"
+
+#ifdef ALLOC_COUNT
+// test/alloc_test.c counts the heap calls libpq makes for a batch apart
+extern void alloc_libpq(bool inside);
+#else
+#define alloc_libpq(inside)
+#endif
+
+static PGconn *conn;
+static char series[4 * PGSINK_SERIES_CHARS + 1];   // UTF-8
+static long series_id;
+static struct pgcopy_t streams[PGSINK_MAXSTREAMS];
+static int nstreams;
+static bool streams_full;               // PGSINK_MAXSTREAMS reported
+static void (*hooks[PGSINK_MAXHOOKS])(bool final);
+static int nhooks;
+static long flush_ms = PGSINK_FLUSH_MS;
+
+// signature, flags field, header extension length
+static const char copy_header[19] = "PGCOPY\n\377\r\n\0\0\0\0\0\0\0\0\0";
+static const char copy_trailer[2] = "\377\377";
+
+static bool pgsink_exec(const char *sql)
+{
+    PGresult *res = PQexec(conn, sql);
+    bool ok = (PGRES_COMMAND_OK == PQresultStatus(res));
+
+    if (!ok) {
+        (void)fprintf(stderr, "pgsink: %s", PQerrorMessage(conn));
+        metrics_add(M_DBERRORS, 1);
+    }
+    PQclear(res);
+    return ok;
+}
+
+// a known series returns no row from the INSERT, nor touches its tuple
+#define SERIES_SQL \
+    "INSERT INTO \"Измерения\".\"Серии\" (\"Название\") VALUES ($1) " \
+    "ON CONFLICT (\"Название\") DO NOTHING RETURNING \"Код\""
+#define SERIES_SELECT_SQL \
+    "SELECT \"Код\" FROM \"Измерения\".\"Серии\" WHERE \"Название\" = $1"
+
+// after a failure: reconnect if the connection itself is gone
+static void pgsink_recover(void)
+{
+    if (CONNECTION_BAD == PQstatus(conn)) {
+        metrics_add(M_RECONNECTS, 1);
+        PQreset(conn);
+    }
+}
+
+// rows in all COPY buffers, for the queue depth gauge
+static void pgsink_queued(void)
+{
+    unsigned long n = 0;
+    int i;
+
+    for (i = 0; i < nstreams; i++) {
+        n += streams[i].rows;
+    }
+    metrics_set(M_QUEUED, n);
+}
+
+// look up or add the series, keep its key
+static bool pgsink_register(void)
+{
+    const char *params[1] = {series};
+    PGresult *res = PQexecParams(conn, SERIES_SQL, 1, NULL, params, NULL,
+                                 NULL, 0);
+    bool ok = (PGRES_TUPLES_OK == PQresultStatus(res));
+
+    if (ok &&
+        0 == PQntuples(res)) {
+        PQclear(res);
+        res = PQexecParams(conn, SERIES_SELECT_SQL, 1, NULL, params, NULL,
+                           NULL, 0);
+        ok = (PGRES_TUPLES_OK == PQresultStatus(res));
+    }
+    ok = ok && 1 == PQntuples(res);
+    if (ok) {
+        series_id = strtol(PQgetvalue(res, 0, 0), NULL, 10);
+    } else {
+        (void)fprintf(stderr, "pgsink: series %s not registered: %s",
+                      series, PQerrorMessage(conn));
+    }
+    PQclear(res);
+    return ok;
+}
+
+bool pgsink_open(const char *conninfo, const char *name)
+{
+    const unsigned char *p;
+    unsigned chars = 0;
+
+    // varchar(80) counts characters; continuation bytes are 10xxxxxx
+    for (p = (const unsigned char *)name; '\0' != *p; p++) {
+        chars += 0x80 != (*p & 0xc0);
+    }
+    if (PGSINK_SERIES_CHARS < chars ||
+        sizeof(series) <= (size_t)(p - (const unsigned char *)name)) {
+        (void)fprintf(stderr, "pgsink: series name longer than %d "
+                      "characters\n", PGSINK_SERIES_CHARS);
+        return false;
+    }
+    conn = PQconnectdb(conninfo);
+    if (CONNECTION_OK != PQstatus(conn)) {
+        (void)fprintf(stderr, "pgsink: %s", PQerrorMessage(conn));
+        PQfinish(conn);
+        conn = NULL;
+        return false;
+    }
+    (void)snprintf(series, sizeof(series), "%s", name);
+    if (!pgsink_register()) {
+        PQfinish(conn);
+        conn = NULL;
+        return false;
+    }
+    return true;
+}
+
+// -F: longest a row may wait for its COPY, in ms
+bool pgsink_freshness(const char *spec)
+{
+    char *end;
+    long ms = strtol(spec, &end, 10);
+
+    if (end == spec ||
+        '\0' != *end ||
+        10 > ms ||
+        3600000 < ms) {
+        return false;
+    }
+    flush_ms = ms;
+    return true;
+}
+
+// b - a in ms
+static long ms_since(const struct timespec *a, const struct timespec *b)
+{
+    return (long)(b->tv_sec - a->tv_sec) * 1000 +
+           (b->tv_nsec - a->tv_nsec) / 1000000;
+}
+
+bool pgsink_active(void)
+{
+    return NULL != conn;
+}
+
+// key of the series in "Серии", 0 without a database
+long pgsink_series_id(void)
+{
+    return series_id;
+}
+
+/* Create (if needed) the LIST partition of schema.table holding the
+ * current series and write its name into leaf: the parent name and the
+ * series key.  The series name goes into the comment. */
+static bool pgsink_partition(const char *qschema, const char *table,
+                             char *leaf, size_t leaflen)
+{
+    char sql[1024];
+    char *qparent, *qleaf, *lit;
+    bool ok;
+
+    (void)snprintf(leaf, leaflen, "%s_%ld", table, series_id);
+
+    qparent = PQescapeIdentifier(conn, table, strlen(table));
+    qleaf = PQescapeIdentifier(conn, leaf, strlen(leaf));
+    lit = PQescapeLiteral(conn, series, strlen(series));
+    if (NULL == qparent ||
+        NULL == qleaf ||
+        NULL == lit) {
+        ok = false;
+    } else {
+        (void)snprintf(sql, sizeof(sql),
+                       "CREATE TABLE IF NOT EXISTS %s.%s PARTITION OF %s.%s "
+                       "FOR VALUES IN (%ld)",
+                       qschema, qleaf, qschema, qparent, series_id);
+        ok = pgsink_exec(sql);
+        if (ok) {
+            (void)snprintf(sql, sizeof(sql), "COMMENT ON TABLE %s.%s IS %s",
+                           qschema, qleaf, lit);
+            (void)pgsink_exec(sql);
+        }
+    }
+    PQfreemem(qparent);
+    PQfreemem(qleaf);
+    PQfreemem(lit);
+    return ok;
+}
+
+struct pgcopy_t *pgsink_stream(const char *schema, const char *table,
+                               const char *columns, bool partitioned)
+{
+    struct pgcopy_t *c;
+    char leaf[128];
+    char *qschema, *qtable;
+
+    if (NULL == conn) {
+        return NULL;
+    }
+    if (PGSINK_MAXSTREAMS <= nstreams) {
+        // callers retry every epoch, say it once
+        if (!streams_full) {
+            (void)fprintf(stderr, "pgsink: all %d streams in use, %s.%s "
+                          "and later tables not written\n",
+                          PGSINK_MAXSTREAMS, schema, table);
+            streams_full = true;
+        }
+        return NULL;
+    }
+    qschema = PQescapeIdentifier(conn, schema, strlen(schema));
+    if (NULL == qschema) {
+        return NULL;
+    }
+    if (partitioned &&
+        pgsink_partition(qschema, table, leaf, sizeof(leaf))) {
+        table = leaf;
+    } else if (partitioned) {
+        (void)fprintf(stderr, "pgsink: no partition for series, "
+                      "writing to %s.%s\n", schema, table);
+    }
+    qtable = PQescapeIdentifier(conn, table, strlen(table));
+    if (NULL == qtable) {
+        PQfreemem(qschema);
+        return NULL;
+    }
+
+    c = &streams[nstreams++];
+    memset(c, 0, sizeof(*c));
+    c->batch = PGSINK_BATCH_ROWS;
+    (void)snprintf(c->stmt, sizeof(c->stmt),
+                   "COPY %s.%s (%s) FROM STDIN (FORMAT binary)",
+                   qschema, qtable, columns);
+    PQfreemem(qschema);
+    PQfreemem(qtable);
+    return c;
+}
+
+// one statement with text parameters, for the occasional summary row
+bool pgsink_params(const char *sql, int nparams, const char *const *values)
+{
+    PGresult *res;
+    bool ok;
+
+    if (NULL == conn) {
+        return false;
+    }
+    alloc_libpq(true);
+    res = PQexecParams(conn, sql, nparams, NULL, values, NULL, NULL, 0);
+    ok = (PGRES_COMMAND_OK == PQresultStatus(res));
+    if (!ok) {
+        (void)fprintf(stderr, "pgsink: %s", PQerrorMessage(conn));
+        metrics_add(M_DBERRORS, 1);
+        pgsink_recover();
+    }
+    PQclear(res);
+    alloc_libpq(false);
+    return ok;
+}
+
+void pgsink_hook(void (*fn)(bool final))
+{
+    int i;
+
+    for (i = 0; i < nhooks; i++) {
+        if (fn == hooks[i]) {
+            return;
+        }
+    }
+    if (PGSINK_MAXHOOKS <= nhooks) {
+        (void)fprintf(stderr, "pgsink: all %d hooks in use, one dropped\n",
+                      PGSINK_MAXHOOKS);
+        return;
+    }
+    hooks[nhooks++] = fn;
+}
+
+/* After a flush of rows that took rtt ms: double the batch if flushing
+ * takes too much of the time or failed, else shrink it by a row if the
+ * batch size was what triggered it.  A flush for any other reason, age
+ * or a full buffer, caps the batch at the rows it found. */
+static void pgsink_tune(struct pgcopy_t *c, const struct timespec *start,
+                        long rtt, bool ok)
+{
+    unsigned rows = c->rows;
+    long interval = 0 == c->flushed.tv_sec ? 0 : ms_since(&c->flushed, start);
+
+    c->flushed = *start;
+    if (!ok ||
+        (0 < interval &&
+         100 * rtt > PGSINK_DUTY_PCT * interval)) {
+        c->batch = PGSINK_BATCH_MAX / 2 > c->batch ? c->batch * 2
+                                                   : PGSINK_BATCH_MAX;
+    } else if (rows >= c->batch) {
+        if (1 < c->batch) {
+            c->batch--;
+        }
+    } else if (0 < rows) {
+        c->batch = rows;
+    }
+}
+
+// ship all complete tuples of one stream as a single COPY
+bool pgsink_flush(struct pgcopy_t *c)
+{
+    PGresult *res;
+    struct timespec start, end;
+    bool ok;
+
+    if (NULL == conn ||
+        0 == c->rows) {
+        return true;
+    }
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    alloc_libpq(true);
+    res = PQexec(conn, c->stmt);
+    ok = (PGRES_COPY_IN == PQresultStatus(res));
+    PQclear(res);
+    if (ok) {
+        ok = 1 == PQputCopyData(conn, copy_header, sizeof(copy_header)) &&
+             1 == PQputCopyData(conn, (const char *)c->buf, (int)c->len) &&
+             1 == PQputCopyData(conn, copy_trailer, sizeof(copy_trailer));
+        if (1 != PQputCopyEnd(conn, ok ? NULL : "client send failed")) {
+            ok = false;
+        }
+        while (NULL != (res = PQgetResult(conn))) {
+            if (PGRES_COMMAND_OK != PQresultStatus(res)) {
+                ok = false;
+            }
+            PQclear(res);
+        }
+    }
+    alloc_libpq(false);
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+    metrics_set(M_COPY_MS, (unsigned long)ms_since(&start, &end));
+    pgsink_tune(c, &start, ms_since(&start, &end), ok);
+    if (ok) {
+        metrics_add(M_ROWS, c->rows);
+    } else {
+        (void)fprintf(stderr, "pgsink: %u rows lost: %s",
+                      c->rows, PQerrorMessage(conn));
+        metrics_add(M_LOST, c->rows);
+        metrics_add(M_DBERRORS, 1);
+        pgsink_recover();
+    }
+    c->len = c->row_start = 0;
+    c->rows = 0;
+    pgsink_queued();
+    return ok;
+}
+
+// flush streams whose oldest pending tuple is older than -F
+void pgsink_poll(void)
+{
+    struct timespec now;
+    int i;
+
+    if (NULL == conn) {
+        return;
+    }
+    for (i = 0; i < nhooks; i++) {
+        hooks[i](false);
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    for (i = 0; i < nstreams; i++) {
+        if (0 < streams[i].rows &&
+            flush_ms <= ms_since(&streams[i].first, &now)) {
+            (void)pgsink_flush(&streams[i]);
+        }
+    }
+}
+
+void pgsink_close(void)
+{
+    int i;
+
+    if (NULL == conn) {
+        return;
+    }
+    for (i = 0; i < nhooks; i++) {
+        hooks[i](true);
+    }
+    for (i = 0; i < nstreams; i++) {
+        (void)pgsink_flush(&streams[i]);
+    }
+    PQfinish(conn);
+    conn = NULL;
+    nstreams = 0;
+    nhooks = 0;
+}
+
+/*
+ * Tuple builders.  Values go out in network byte order, each field
+ * preceded by its int32 length (-1 for NULL).
+ */
+
+static bool pgcopy_room(struct pgcopy_t *c, size_t n)
+{
+    if (c->overflow ||
+        sizeof(c->buf) < c->len + n) {
+        c->overflow = true;
+        return false;
+    }
+    return true;
+}
+
+static void pgcopy_put32(struct pgcopy_t *c, uint32_t v)
+{
+    putbe32(c->buf, c->len, v);
+    c->len += 4;
+}
+
+static void pgcopy_put64(struct pgcopy_t *c, uint64_t v)
+{
+    pgcopy_put32(c, (uint32_t)(v >> 32));
+    pgcopy_put32(c, (uint32_t)v);
+}
+
+void pgcopy_row(struct pgcopy_t *c, int nfields)
+{
+    // keep a quarter of the buffer free for the tuple being built
+    if (sizeof(c->buf) / 4 > sizeof(c->buf) - c->len) {
+        (void)pgsink_flush(c);
+    }
+    c->row_start = c->len;
+    c->overflow = false;
+    if (pgcopy_room(c, 2)) {
+        putbe16(c->buf, c->len, (unsigned)nfields);
+        c->len += 2;
+    }
+}
+
+void pgcopy_null(struct pgcopy_t *c)
+{
+    if (pgcopy_room(c, 4)) {
+        pgcopy_put32(c, 0xffffffffU);
+    }
+}
+
+void pgcopy_int2(struct pgcopy_t *c, int v)
+{
+    if (pgcopy_room(c, 6)) {
+        pgcopy_put32(c, 2);
+        putbe16(c->buf, c->len, (unsigned)v & 0xffff);
+        c->len += 2;
+    }
+}
+
+/* Header of an array field of n elements of type oid, size elemlen,
+ * none NULL: one dimension, lower bound 1.  Each element follows with
+ * its own length word. */
+static bool pgcopy_array(struct pgcopy_t *c, uint32_t oid, unsigned n,
+                         size_t elemlen)
+{
+    size_t len = 20 + (size_t)n * (4 + elemlen);
+
+    if (!pgcopy_room(c, 4 + len)) {
+        return false;
+    }
+    pgcopy_put32(c, (uint32_t)len);
+    pgcopy_put32(c, 1);                 // ndim
+    pgcopy_put32(c, 0);                 // no NULLs
+    pgcopy_put32(c, oid);
+    pgcopy_put32(c, n);
+    pgcopy_put32(c, 1);                 // lower bound
+    return true;
+}
+
+void pgcopy_int2_array(struct pgcopy_t *c, const int16_t *v, unsigned n)
+{
+    unsigned i;
+
+    if (!pgcopy_array(c, 21, n, 2)) {   // int2
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        pgcopy_put32(c, 2);
+        putbe16(c->buf, c->len, (unsigned)v[i] & 0xffff);
+        c->len += 2;
+    }
+}
+
+void pgcopy_int4(struct pgcopy_t *c, long v)
+{
+    if (pgcopy_room(c, 8)) {
+        pgcopy_put32(c, 4);
+        pgcopy_put32(c, (uint32_t)v);
+    }
+}
+
+void pgcopy_int8(struct pgcopy_t *c, int64_t v)
+{
+    if (pgcopy_room(c, 12)) {
+        pgcopy_put32(c, 8);
+        pgcopy_put64(c, (uint64_t)v);
+    }
+}
+
+void pgcopy_float8(struct pgcopy_t *c, double v)
+{
+    uint64_t u;
+
+    memcpy(&u, &v, sizeof(u));
+    if (pgcopy_room(c, 12)) {
+        pgcopy_put32(c, 8);
+        pgcopy_put64(c, u);
+    }
+}
+
+void pgcopy_bool(struct pgcopy_t *c, bool v)
+{
+    if (pgcopy_room(c, 5)) {
+        pgcopy_put32(c, 1);
+        c->buf[c->len++] = v ? 1 : 0;
+    }
+}
+
+void pgcopy_bool_array(struct pgcopy_t *c, const bool *v, unsigned n)
+{
+    unsigned i;
+
+    if (!pgcopy_array(c, 16, n, 1)) {   // bool
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        pgcopy_put32(c, 1);
+        c->buf[c->len++] = v[i] ? 1 : 0;
+    }
+}
+
+void pgcopy_text(struct pgcopy_t *c, const char *s)
+{
+    size_t n = strlen(s);
+
+    if (pgcopy_room(c, 4 + n)) {
+        pgcopy_put32(c, (uint32_t)n);
+        memcpy(c->buf + c->len, s, n);
+        c->len += n;
+    }
+}
+
+// time without time zone: int8 microseconds since midnight
+void pgcopy_time(struct pgcopy_t *c, int64_t usec)
+{
+    pgcopy_int8(c, usec);
+}
+
+// timestamptz from a CLOCK_REALTIME reading: int8 microseconds since 2000
+void pgcopy_timespec(struct pgcopy_t *c, const struct timespec *ts)
+{
+    pgcopy_int8(c, (int64_t)ts->tv_sec * 1000000 + ts->tv_nsec / 1000 -
+                   PG_UNIX_EPOCH_USEC);
+}
+
+void pgcopy_commit(struct pgcopy_t *c)
+{
+    if (c->overflow) {
+        // tuple larger than the whole buffer, nothing to do but drop it
+        c->len = c->row_start;
+        c->overflow = false;
+        (void)fputs("pgsink: oversized row dropped\n", stderr);
+        return;
+    }
+    if (0 == c->rows++) {
+        (void)clock_gettime(CLOCK_MONOTONIC, &c->first);
+    }
+    c->row_start = c->len;
+    if (c->batch <= c->rows) {
+        (void)pgsink_flush(c);
+    } else {
+        pgsink_queued();
+    }
+}
+
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,213 @@
+/*
+ * Running position statistics of the current series.
+ *
+ * Every fix updates the mean, the covariance and the extremes in O(1)
+ * (Welford's algorithm), and every POSSTATS_SAVE_SEC the result is
+ * written as one row of "Измерения"."Сводка", so the spread of a point
+ * is known while it is being measured, without scanning the raw rows.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "include/geo.h"
+#include "include/gps.h"              // for DEG_2_RAD
+#include "include/pgsink.h"
+#include "include/posstats.h"
+#include "include/qgate.h"
+
+#define SUMMARY_SQL \
+    "INSERT INTO \"Измерения\".\"Сводка\" (\"Серия\", \"Начало\", " \
+    "\"Эпох\", φ, λ, h, \"σE\", \"σN\", \"σU\", \"cEN\", \"cEU\", " \
+    "\"cNU\", \"φ min\", \"φ max\", \"λ min\", \"λ max\", \"h min\", " \
+    "\"h max\", \"Отброшено\", \"Обновлено\") " \
+    "VALUES ($1, to_timestamp($2), $3, $4, $5, $6, $7, $8, $9, $10, " \
+    "$11, $12, $13, $14, $15, $16, $17, $18, $19, now()) " \
+    "ON CONFLICT (\"Серия\", \"Начало\") DO UPDATE SET " \
+    "\"Эпох\" = EXCLUDED.\"Эпох\", φ = EXCLUDED.φ, λ = EXCLUDED.λ, " \
+    "h = EXCLUDED.h, \"σE\" = EXCLUDED.\"σE\", " \
+    "\"σN\" = EXCLUDED.\"σN\", \"σU\" = EXCLUDED.\"σU\", " \
+    "\"cEN\" = EXCLUDED.\"cEN\", \"cEU\" = EXCLUDED.\"cEU\", " \
+    "\"cNU\" = EXCLUDED.\"cNU\", \"φ min\" = EXCLUDED.\"φ min\", " \
+    "\"φ max\" = EXCLUDED.\"φ max\", \"λ min\" = EXCLUDED.\"λ min\", " \
+    "\"λ max\" = EXCLUDED.\"λ max\", \"h min\" = EXCLUDED.\"h min\", " \
+    "\"h max\" = EXCLUDED.\"h max\", " \
+    "\"Отброшено\" = EXCLUDED.\"Отброшено\", \"Обновлено\" = now()"
+#define SUMMARY_PARAMS  19
+
+static struct posstats_t series_stats;
+static time_t started;                  // this run, part of the row key
+static struct timespec saved;           // CLOCK_MONOTONIC of last save
+static unsigned long saved_n, saved_rejected;
+
+void posstats_add(struct posstats_t *ps, const double ecef[3],
+                  double lat, double lon, double alt)
+{
+    const double llh[3] = {lat, lon, alt};
+    double d[3], d2[3];
+    int i;
+
+    ps->n++;
+    for (i = 0; i < 3; i++) {
+        d[i] = ecef[i] - ps->mean[i];
+        ps->mean[i] += d[i] / (double)ps->n;
+        d2[i] = ecef[i] - ps->mean[i];
+        if (1 == ps->n ||
+            llh[i] < ps->min[i]) {
+            ps->min[i] = llh[i];
+        }
+        if (1 == ps->n ||
+            llh[i] > ps->max[i]) {
+            ps->max[i] = llh[i];
+        }
+    }
+    ps->m2[0] += d[0] * d2[0];
+    ps->m2[1] += d[0] * d2[1];
+    ps->m2[2] += d[0] * d2[2];
+    ps->m2[3] += d[1] * d2[1];
+    ps->m2[4] += d[1] * d2[2];
+    ps->m2[5] += d[2] * d2[2];
+}
+
+/* Sample covariance rotated into east, north, up at lat, lon (degrees):
+ * cov = ee, en, eu, nn, nu, uu in m^2, NaN below two samples. */
+void posstats_enu(const struct posstats_t *ps, double lat, double lon,
+                  double cov[6])
+{
+    double sp = sin(lat * DEG_2_RAD), cp = cos(lat * DEG_2_RAD);
+    double sl = sin(lon * DEG_2_RAD), cl = cos(lon * DEG_2_RAD);
+    const double r[3][3] = {
+        {-sl, cl, 0.0},
+        {-sp * cl, -sp * sl, cp},
+        {cp * cl, cp * sl, sp},
+    };
+    double c[3][3], rc[3][3];
+    int i, j, k, n;
+
+    if (2 > ps->n) {
+        for (i = 0; i < 6; i++) {
+            cov[i] = NAN;
+        }
+        return;
+    }
+    c[0][0] = ps->m2[0];
+    c[0][1] = c[1][0] = ps->m2[1];
+    c[0][2] = c[2][0] = ps->m2[2];
+    c[1][1] = ps->m2[3];
+    c[1][2] = c[2][1] = ps->m2[4];
+    c[2][2] = ps->m2[5];
+
+    // rc = R * C, then cov = rc * R^T, upper triangle only
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++) {
+            rc[i][j] = 0.0;
+            for (k = 0; k < 3; k++) {
+                rc[i][j] += r[i][k] * c[k][j];
+            }
+        }
+    }
+    n = 0;
+    for (i = 0; i < 3; i++) {
+        for (j = i; j < 3; j++) {
+            double s = 0.0;
+
+            for (k = 0; k < 3; k++) {
+                s += rc[i][k] * r[j][k];
+            }
+            cov[n++] = s / (double)(ps->n - 1);
+        }
+    }
+}
+
+static void posstats_save(bool final)
+{
+    char val[SUMMARY_PARAMS][32];
+    const char *params[SUMMARY_PARAMS];
+    double lat, lon, alt;
+    struct timespec now;
+    double cov[6];
+    int i;
+
+    if (saved_n == series_stats.n &&
+        saved_rejected == qgate_rejected()) {
+        return;
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    if (!final &&
+        POSSTATS_SAVE_SEC > now.tv_sec - saved.tv_sec) {
+        return;
+    }
+    saved = now;
+    saved_n = series_stats.n;
+    saved_rejected = qgate_rejected();
+
+    geo_ecef_to_llh(series_stats.mean[0], series_stats.mean[1],
+                    series_stats.mean[2], &lat, &lon, &alt);
+    posstats_enu(&series_stats, lat, lon, cov);
+
+    (void)snprintf(val[0], sizeof(val[0]), "%ld", pgsink_series_id());
+    (void)snprintf(val[1], sizeof(val[1]), "%lld", (long long)started);
+    (void)snprintf(val[2], sizeof(val[2]), "%lu", series_stats.n);
+    (void)snprintf(val[3], sizeof(val[3]), "%.10f", lat);
+    (void)snprintf(val[4], sizeof(val[4]), "%.10f", lon);
+    (void)snprintf(val[5], sizeof(val[5]), "%.4f", alt);
+    (void)snprintf(val[6], sizeof(val[6]), "%.6g", sqrt(cov[0]));
+    (void)snprintf(val[7], sizeof(val[7]), "%.6g", sqrt(cov[3]));
+    (void)snprintf(val[8], sizeof(val[8]), "%.6g", sqrt(cov[5]));
+    (void)snprintf(val[9], sizeof(val[9]), "%.6g", cov[1]);
+    (void)snprintf(val[10], sizeof(val[10]), "%.6g", cov[2]);
+    (void)snprintf(val[11], sizeof(val[11]), "%.6g", cov[4]);
+    for (i = 0; i < 3; i++) {
+        (void)snprintf(val[12 + 2 * i], sizeof(val[0]), "%.10f",
+                       series_stats.min[i]);
+        (void)snprintf(val[13 + 2 * i], sizeof(val[0]), "%.10f",
+                       series_stats.max[i]);
+    }
+    (void)snprintf(val[18], sizeof(val[18]), "%lu", saved_rejected);
+    for (i = 0; i < SUMMARY_PARAMS; i++) {
+        params[i] = val[i];
+    }
+    // nothing accepted yet: only the count and the rejections
+    if (0 == series_stats.n) {
+        for (i = 3; i < 18; i++) {
+            params[i] = NULL;
+        }
+    }
+    (void)pgsink_params(SUMMARY_SQL, SUMMARY_PARAMS, params);
+}
+
+// the first epoch of this run, accepted or not, starts its row
+static void posstats_start(void)
+{
+    if (0 != started) {
+        return;
+    }
+    started = time(NULL);
+    (void)clock_gettime(CLOCK_MONOTONIC, &saved);
+    if (pgsink_active()) {
+        pgsink_hook(posstats_save);
+    }
+}
+
+// one fix of the current series; lat, lon, alt only for the extremes
+void posstats_fix(const double ecef[3], double lat, double lon, double alt)
+{
+    posstats_start();
+    posstats_add(&series_stats, ecef, lat, lon, alt);
+}
+
+/* One epoch refused by the quality gate.  qgate keeps the count; this
+ * only makes sure the row is written, even if every epoch is refused. */
+void posstats_rejected(void)
+{
+    posstats_start();
+}
+
+// vim: set expandtab shiftwidth=4
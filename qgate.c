@@ -0,0 +1,218 @@
+/*
+ * Fix quality gate in front of storage.
+ *
+ * Every epoch is checked before it reaches the database or the
+ * statistics.  The fixed tests are cheap comparisons against the
+ * limits given with -q.  The outlier test keeps the last win positions
+ * (ECEF), takes their per-axis median and the median of their
+ * distances to it (MAD), and rejects a position farther from the
+ * median than mad * 1.4826 MAD.  The deviations are 3-D distances, not
+ * normal errors on one axis, so 1.4826 is only the conventional scale
+ * of a MAD, not a conversion to a standard deviation.
+ * The window takes every epoch that passed the fixed tests, accepted
+ * or not, so that a real move of the antenna is followed within half
+ * a window instead of being rejected forever.
+ *
+ * Rejected epochs are only counted, per reason.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/driver_ubx.h"
+#include "include/metrics.h"
+#include "include/qgate.h"
+
+#define MAD_SIGMA       1.4826  // conventional MAD scale, radial deviations
+#define MIN_DEV         0.10    // m, never reject closer than this
+
+unsigned long qgate_rejects[QGATE_VERDICTS];
+
+static struct {
+    int minfix;                 // 0 none, 2 2D, 3 3D
+    int minsats;
+    double maxpdop;             // 0 for no limit
+    double maxacc;              // m, 0 for no limit
+    double madk;                // 0 for no outlier test
+    unsigned win;
+} gate = {0, 0, 0.0, 0.0, 0.0, 31};
+
+static double ring[QGATE_MAXWIN][3];
+static unsigned nring, head;
+
+/* Parse -q: comma separated fix=N, sats=N, pdop=X, acc=M, mad=K and
+ * win=N.  Unknown keys or bad numbers are an error. */
+bool qgate_config(const char *spec)
+{
+    char copy[128];
+    char *tok, *save = NULL;
+
+    if (sizeof(copy) <= strlen(spec)) {
+        return false;
+    }
+    (void)strncpy(copy, spec, sizeof(copy));
+    for (tok = strtok_r(copy, ",", &save); NULL != tok;
+         tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        char *end;
+        double v;
+
+        if (NULL == eq) {
+            return false;
+        }
+        *eq++ = '\0';
+        v = strtod(eq, &end);
+        if (end == eq ||
+            '\0' != *end ||
+            0 > v) {
+            return false;
+        }
+        if (0 == strcmp(tok, "fix")) {
+            gate.minfix = (int)v;
+        } else if (0 == strcmp(tok, "sats")) {
+            gate.minsats = (int)v;
+        } else if (0 == strcmp(tok, "pdop")) {
+            gate.maxpdop = v;
+        } else if (0 == strcmp(tok, "acc")) {
+            gate.maxacc = v;
+        } else if (0 == strcmp(tok, "mad")) {
+            gate.madk = v;
+        } else if (0 == strcmp(tok, "win") &&
+                   3 <= v &&
+                   QGATE_MAXWIN >= v) {
+            gate.win = (unsigned)v;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// k-th smallest of a[0..n), reorders a
+static double select_kth(double *a, unsigned n, unsigned k)
+{
+    unsigned lo = 0, hi = n - 1;
+
+    while (lo < hi) {
+        double pivot = a[(lo + hi) / 2];
+        unsigned i = lo, j = hi;
+
+        while (i <= j) {
+            while (a[i] < pivot) {
+                i++;
+            }
+            while (a[j] > pivot) {
+                j--;
+            }
+            if (i <= j) {
+                double t = a[i];
+
+                a[i] = a[j];
+                a[j] = t;
+                i++;
+                if (0 == j) {
+                    break;
+                }
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+    return a[k];
+}
+
+static bool qgate_outlier(const double *ecef)
+{
+    double med[3], tmp[QGATE_MAXWIN], dev, mad;
+    unsigned i;
+    int axis;
+    bool outlier = false;
+
+    if (gate.win == nring) {
+        for (axis = 0; axis < 3; axis++) {
+            for (i = 0; i < nring; i++) {
+                tmp[i] = ring[i][axis];
+            }
+            med[axis] = select_kth(tmp, nring, nring / 2);
+        }
+        for (i = 0; i < nring; i++) {
+            tmp[i] = sqrt(pow(ring[i][0] - med[0], 2) +
+                          pow(ring[i][1] - med[1], 2) +
+                          pow(ring[i][2] - med[2], 2));
+        }
+        mad = select_kth(tmp, nring, nring / 2);
+        dev = sqrt(pow(ecef[0] - med[0], 2) +
+                   pow(ecef[1] - med[1], 2) +
+                   pow(ecef[2] - med[2], 2));
+        outlier = dev > MIN_DEV &&
+                  dev > gate.madk * MAD_SIGMA * mad;
+    }
+
+    memcpy(ring[head], ecef, sizeof(ring[head]));
+    head = (head + 1) % gate.win;
+    if (gate.win > nring) {
+        nring++;
+    }
+    return outlier;
+}
+
+/* Verdict on one epoch, QGATE_OK to store it.  ecef is NULL when the
+ * epoch has no position. */
+int qgate_check(unsigned navmode, unsigned flags, int sats,
+                double pdop, double acc, const double *ecef)
+{
+    // NAV-SOL gpsFix to fix dimension: DR only and time only count as none
+    static const int dims[] = {0, 0, 2, 3, 3, 0};
+    int verdict = QGATE_OK;
+
+    if (NULL == ecef ||
+        0 == (flags & UBX_SOL_FLAG_GPS_FIX_OK)) {
+        verdict = QGATE_NOPOS;
+    } else if ((sizeof(dims) / sizeof(dims[0]) <= navmode ?
+                0 : dims[navmode]) < gate.minfix) {
+        verdict = QGATE_FIX;
+    } else if (sats < gate.minsats) {
+        verdict = QGATE_SATS;
+    } else if (0 < gate.maxpdop &&
+               !(pdop <= gate.maxpdop)) {
+        verdict = QGATE_PDOP;
+    } else if (0 < gate.maxacc &&
+               !(acc <= gate.maxacc)) {
+        verdict = QGATE_ACC;
+    } else if (0 < gate.madk &&
+               qgate_outlier(ecef)) {
+        verdict = QGATE_OUTLIER;
+    }
+    qgate_rejects[verdict]++;
+    if (QGATE_OK != verdict) {
+        metrics_add(M_REJECTS, 1);
+    }
+    return verdict;
+}
+
+unsigned long qgate_rejected(void)
+{
+    unsigned long n = 0;
+    int i;
+
+    for (i = QGATE_OK + 1; i < QGATE_VERDICTS; i++) {
+        n += qgate_rejects[i];
+    }
+    return n;
+}
+
+// vim: set expandtab shiftwidth=4
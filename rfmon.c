@@ -0,0 +1,166 @@
+/*
+ * RF front end monitoring: noise floor, AGC, jamming indicator and
+ * antenna status from MON-RF, or MON-HW and MON-HW2 on older receivers.
+ *
+ * The jamming alert runs on the sample itself, before and apart from
+ * any storage, so it fires with the packet even when the database is
+ * slow or absent.
+ *
+ * For storage each RF block collects RFMON_SAMPLES samples as the
+ * first one and signed byte differences to the previous; these values
+ * change little from one cycle to the next.  A difference that does not
+ * fit a byte closes the block early.  A full block goes out as one row
+ * of "Измерения"."U-Blox-помехи" with one int2[] per quantity, instead
+ * of one row per sample, through the same batched COPY as the fixes.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "include/pgsink.h"
+#include "include/rfmon.h"
+
+#define RFMON_COLUMNS "\"Серия\", \"Блок\", \"Начало\", \"Конец\", " \
+                      "\"Шум\", \"АРУ\", \"Помехи\", \"Состояние\", " \
+                      "\"Антенна\", \"Питание антенны\", \"Амплитуда I\", " \
+                      "\"Амплитуда Q\""
+#define RFMON_ROW_FIELDS        (4 + RFMON_FIELDS)
+
+struct rfblock_t {
+    struct timespec first, last;        // host clock, first and last sample
+    int base[RFMON_FIELDS];             // the first sample
+    int prev[RFMON_FIELDS];
+    int8_t delta[RFMON_SAMPLES][RFMON_FIELDS];  // [i] = sample i - sample i-1
+    unsigned n;
+    bool jammed;
+};
+
+static struct rfblock_t blocks[RFMON_BLOCKS];
+static struct pgcopy_t *rfcopy;
+static int alert_level;
+static rfmon_alert_t alert_fn;
+
+// fn on crossing threshold, 0 for none
+void rfmon_alert(int threshold, rfmon_alert_t fn)
+{
+    alert_level = threshold;
+    alert_fn = fn;
+}
+
+static void rfmon_flush(unsigned id)
+{
+    struct rfblock_t *b = &blocks[id];
+    int16_t col[RFMON_SAMPLES];
+    unsigned i;
+    int f;
+
+    if (0 == b->n ||
+        NULL == rfcopy) {
+        return;
+    }
+    pgcopy_row(rfcopy, RFMON_ROW_FIELDS);
+    pgcopy_int4(rfcopy, pgsink_series_id());
+    pgcopy_int2(rfcopy, (int)id);
+    // no host clock under -r
+    if (0 == b->first.tv_sec) {
+        pgcopy_null(rfcopy);
+        pgcopy_null(rfcopy);
+    } else {
+        pgcopy_timespec(rfcopy, &b->first);
+        pgcopy_timespec(rfcopy, &b->last);
+    }
+    for (f = 0; f < RFMON_FIELDS; f++) {
+        int v = b->base[f];
+        bool known = 0 <= v;
+
+        col[0] = (int16_t)v;
+        for (i = 1; i < b->n; i++) {
+            v += b->delta[i][f];
+            col[i] = (int16_t)v;
+            known |= 0 <= v;
+        }
+        // I/Q is -1 without MON-HW2; a row with none of it gets NULL
+        if (known) {
+            pgcopy_int2_array(rfcopy, col, b->n);
+        } else {
+            pgcopy_null(rfcopy);
+        }
+    }
+    pgcopy_commit(rfcopy);
+    b->n = 0;
+}
+
+static void rfmon_final(bool final)
+{
+    unsigned i;
+
+    if (!final) {
+        return;
+    }
+    for (i = 0; i < RFMON_BLOCKS; i++) {
+        rfmon_flush(i);
+    }
+}
+
+// one sample of RF block id, received at rx
+void rfmon_sample(unsigned id, const int v[RFMON_FIELDS],
+                  const struct timespec *rx)
+{
+    struct rfblock_t *b;
+    int f;
+
+    if (RFMON_BLOCKS <= id) {
+        return;
+    }
+    b = &blocks[id];
+
+    if (NULL != alert_fn &&
+        0 < alert_level &&
+        (alert_level <= v[RFMON_JAM]) != b->jammed) {
+        b->jammed = !b->jammed;
+        alert_fn(id, v[RFMON_JAM], b->jammed);
+    }
+
+    if (NULL == rfcopy) {
+        if (!pgsink_active()) {
+            return;
+        }
+        rfcopy = pgsink_stream("Измерения", "U-Blox-помехи", RFMON_COLUMNS,
+                               false);
+        if (NULL == rfcopy) {
+            return;
+        }
+        pgsink_hook(rfmon_final);
+    }
+
+    for (f = 0; 0 < b->n && f < RFMON_FIELDS; f++) {
+        int d = v[f] - b->prev[f];
+
+        if (INT8_MIN > d ||
+            INT8_MAX < d) {
+            rfmon_flush(id);
+        }
+    }
+    if (0 == b->n) {
+        memcpy(b->base, v, sizeof(b->base));
+        b->first = *rx;
+    } else {
+        for (f = 0; f < RFMON_FIELDS; f++) {
+            b->delta[b->n][f] = (int8_t)(v[f] - b->prev[f]);
+        }
+    }
+    memcpy(b->prev, v, sizeof(b->prev));
+    b->last = *rx;
+    if (RFMON_SAMPLES == ++b->n) {
+        rfmon_flush(id);
+    }
+}
+
+// vim: set expandtab shiftwidth=4
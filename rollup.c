@@ -0,0 +1,120 @@
+/*
+ * 1 s, 10 s and 1 min aggregates of the stored fixes.
+ *
+ * Each tier keeps one open bucket, aligned to its length in GPS derived
+ * time.  A fix that falls into a later bucket closes the open one: its
+ * mean position, east/north/up sigma, mean satellite count and mean
+ * pDOP go out as one row of "Измерения"."U-Blox-агрегаты" through the
+ * same batched COPY as the raw fixes.  The last, partial buckets are
+ * written at exit.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "include/geo.h"
+#include "include/pgsink.h"
+#include "include/posstats.h"
+#include "include/rollup.h"
+
+#define ROLLUP_COLUMNS "\"Серия\", \"Интервал\", \"Начало\", \"Эпох\", " \
+                       "φ, λ, h, \"σE\", \"σN\", \"σU\", \"Спутников\", dop"
+#define ROLLUP_TIERS    3
+
+struct bucket_t {
+    int64_t start;              // us since 2000-01-01, PostgreSQL epoch
+    struct posstats_t pos;
+    double sats, pdop;          // sums
+};
+
+static const int64_t tier_usec[ROLLUP_TIERS] = {
+    1000000LL, 10000000LL, 60000000LL,
+};
+static struct bucket_t buckets[ROLLUP_TIERS];
+static struct pgcopy_t *rollcopy;
+
+static void rollup_close(int tier)
+{
+    struct bucket_t *b = &buckets[tier];
+    double lat, lon, alt;
+    double cov[6];
+
+    if (0 == b->pos.n ||
+        NULL == rollcopy) {
+        return;
+    }
+    geo_ecef_to_llh(b->pos.mean[0], b->pos.mean[1], b->pos.mean[2],
+                    &lat, &lon, &alt);
+    posstats_enu(&b->pos, lat, lon, cov);
+
+    pgcopy_row(rollcopy, 12);
+    pgcopy_int4(rollcopy, pgsink_series_id());
+    pgcopy_int4(rollcopy, (long)(tier_usec[tier] / 1000000));
+    pgcopy_int8(rollcopy, b->start);
+    pgcopy_int4(rollcopy, (long)b->pos.n);
+    pgcopy_float8(rollcopy, lat);
+    pgcopy_float8(rollcopy, lon);
+    pgcopy_float8(rollcopy, alt);
+    pgcopy_float8(rollcopy, sqrt(cov[0]));
+    pgcopy_float8(rollcopy, sqrt(cov[3]));
+    pgcopy_float8(rollcopy, sqrt(cov[5]));
+    pgcopy_float8(rollcopy, b->sats / (double)b->pos.n);
+    pgcopy_float8(rollcopy, b->pdop / (double)b->pos.n);
+    pgcopy_commit(rollcopy);
+}
+
+static void rollup_final(bool final)
+{
+    int i;
+
+    if (!final) {
+        return;
+    }
+    for (i = 0; i < ROLLUP_TIERS; i++) {
+        rollup_close(i);
+        memset(&buckets[i], 0, sizeof(buckets[i]));
+    }
+}
+
+// one accepted, timed fix; pg_usec is its "Время"
+void rollup_fix(int64_t pg_usec, const double ecef[3],
+                double lat, double lon, double alt, int sats, double pdop)
+{
+    int i;
+
+    if (NULL == rollcopy) {
+        if (!pgsink_active()) {
+            return;
+        }
+        rollcopy = pgsink_stream("Измерения", "U-Blox-агрегаты",
+                                 ROLLUP_COLUMNS, false);
+        if (NULL == rollcopy) {
+            return;
+        }
+        pgsink_hook(rollup_final);
+    }
+    for (i = 0; i < ROLLUP_TIERS; i++) {
+        struct bucket_t *b = &buckets[i];
+        // floor, also before 2000
+        int64_t start = pg_usec - ((pg_usec % tier_usec[i]) +
+                                   tier_usec[i]) % tier_usec[i];
+
+        if (0 < b->pos.n &&
+            start != b->start) {
+            rollup_close(i);
+            memset(b, 0, sizeof(*b));
+        }
+        b->start = start;
+        posstats_add(&b->pos, ecef, lat, lon, alt);
+        b->sats += sats;
+        b->pdop += pdop;
+    }
+}
+
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,74 @@
+/*
+ * Satellite history, one row per NAV-SAT epoch.
+ *
+ * A row per satellite and epoch pays the tuple header, the series key
+ * and the time once per satellite: 35 satellites at 5 Hz are 175 rows
+ * a second.  Here the epoch is one row of "Измерения"."U-Blox-небо",
+ * each per-satellite quantity an array in channel order, so element i
+ * of every array is the same satellite.  The row goes through the same
+ * batched binary COPY as the fixes, into the partition of the series.
+ *
+ * Most questions about the sky are answered by the passes (passes.c);
+ * these rows are only written with -S.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "include/pgsink.h"
+#include "include/sky.h"
+
+#define SKY_COLUMNS "\"Серия\", \"Приём\", \"iTOW\", \"Система\", " \
+                    "\"Номер\", prn, az, el, ss, fl, ok_sat"
+#define SKY_FIELDS  11
+
+static struct pgcopy_t *skycopy;
+static bool raw;
+
+// -S: store every epoch
+void sky_raw(bool on)
+{
+    raw = on;
+}
+
+// one NAV-SAT epoch, its burst received at rx (0 when replayed)
+void sky_epoch(const struct sky_epoch_t *ep, const struct timespec *rx)
+{
+    if (!raw) {
+        return;
+    }
+    if (NULL == skycopy) {
+        if (!pgsink_active()) {
+            return;
+        }
+        skycopy = pgsink_stream("Измерения", "U-Blox-небо", SKY_COLUMNS,
+                                true);
+        if (NULL == skycopy) {
+            return;
+        }
+    }
+    pgcopy_row(skycopy, SKY_FIELDS);
+    pgcopy_int4(skycopy, pgsink_series_id());
+    if (0 == rx->tv_sec) {
+        pgcopy_null(skycopy);
+    } else {
+        pgcopy_timespec(skycopy, rx);
+    }
+    pgcopy_int4(skycopy, (long)ep->tow);
+    pgcopy_int2_array(skycopy, ep->gnss, ep->n);
+    pgcopy_int2_array(skycopy, ep->sv, ep->n);
+    pgcopy_int2_array(skycopy, ep->prn, ep->n);
+    pgcopy_int2_array(skycopy, ep->az, ep->n);
+    pgcopy_int2_array(skycopy, ep->el, ep->n);
+    pgcopy_int2_array(skycopy, ep->ss, ep->n);
+    pgcopy_int2_array(skycopy, ep->fl, ep->n);
+    pgcopy_bool_array(skycopy, ep->used, ep->n);
+    pgcopy_commit(skycopy);
+}
+
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,261 @@
+/*
+ * Allocation test of the decode path.
+ *
+ * malloc(), calloc(), realloc(), free(), posix_memalign() and
+ * aligned_alloc() are replaced here by wrappers around the glibc
+ * allocator that count their calls; the C library and libpq call them
+ * too.  gpsmon.c is built with ALLOC_COUNT into the same program: it
+ * notes the count after HEAP_WARMUP packets and fails the replay if it
+ * moved by the end.
+ *
+ * main() writes ALLOC_TEST_EPOCHS epochs of NAV-SOL, NAV-DOP, NAV-SAT
+ * and NAV-TIMEUTC, one a second, into a temporary file and replays it
+ * through gpsmon_replay() on standard input at VERB_FIX, so every epoch
+ * goes through the framing, the decoders, the quality gate and the
+ * console line.  The lines themselves go to /dev/null.
+ *
+ * Given a database, the replay also encodes every row into the COPY
+ * buffers and ships the batches.  pgsink.c, built with ALLOC_COUNT too,
+ * marks the libpq calls of each batch: libpq allocates a result object
+ * per COPY and frees it at once, which no buffer of ours can avoid.
+ * Those heap calls are counted apart and reported, not failed.
+ *
+ * Exit status 0 when no other heap call was made after the warmup.
+ * Optional arguments: number of epochs, libpq connection string.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "include/geo.h"
+#include "include/gpsmon.h"
+#include "include/pgsink.h"
+#include "include/ubxframe.h"
+
+#define ALLOC_TEST_EPOCHS   3600        // an hour at 1 Hz
+#define ALLOC_TEST_SATS     24          // satellites in each NAV-SAT
+#define ALLOC_TEST_WEEK     2330        // GPS week of the replay
+#define ALLOC_TEST_LEAP     18          // GPS - UTC, s
+
+// the glibc allocator under the public names
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void *__libc_memalign(size_t, size_t);
+extern void __libc_free(void *);
+
+extern unsigned long alloc_calls(void);
+extern void alloc_libpq(bool inside);
+
+static atomic_ulong calls, libpq_calls;
+static _Thread_local bool in_libpq;
+
+static void count(void)
+{
+    (void)atomic_fetch_add_explicit(in_libpq ? &libpq_calls : &calls, 1,
+                                    memory_order_relaxed);
+}
+
+unsigned long alloc_calls(void)
+{
+    return atomic_load_explicit(&calls, memory_order_relaxed);
+}
+
+// pgsink.c: the calls between true and false are libpq's, for a batch
+void alloc_libpq(bool inside)
+{
+    in_libpq = inside;
+}
+
+void *malloc(size_t size)
+{
+    count();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    count();
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    count();
+    return __libc_realloc(p, size);
+}
+
+void free(void *p)
+{
+    if (NULL != p) {
+        count();
+    }
+    __libc_free(p);
+}
+
+int posix_memalign(void **p, size_t align, size_t size)
+{
+    count();
+    if (0 == align ||
+        0 != (align & (align - 1)) ||
+        0 != align % sizeof(void *)) {
+        return EINVAL;
+    }
+    *p = __libc_memalign(align, size);
+    return NULL == *p ? ENOMEM : 0;
+}
+
+void *aligned_alloc(size_t align, size_t size)
+{
+    count();
+    return __libc_memalign(align, size);
+}
+
+static unsigned char buf[UBX_HDR_LEN + 8 + 12 * ALLOC_TEST_SATS + 2];
+static unsigned char *const payload = buf + UBX_HDR_LEN;
+
+static void put2(size_t off, unsigned v)
+{
+    payload[off] = (unsigned char)v;
+    payload[off + 1] = (unsigned char)(v >> 8);
+}
+
+static void put4(size_t off, unsigned long v)
+{
+    put2(off, (unsigned)(v & 0xffff));
+    put2(off + 2, (unsigned)((v >> 16) & 0xffff));
+}
+
+// frame payload[0..len) as class/id and append it to the stream
+static void frame(FILE *out, unsigned cls, unsigned id, size_t len)
+{
+    buf[0] = UBX_SYNC1;
+    buf[1] = UBX_SYNC2;
+    buf[2] = (unsigned char)cls;
+    buf[3] = (unsigned char)id;
+    buf[4] = (unsigned char)len;
+    buf[5] = (unsigned char)(len >> 8);
+    ubx_checksum(buf + 2, len + 4, &payload[len], &payload[len + 1]);
+    (void)fwrite(buf, 1, UBX_HDR_LEN + len + 2, out);
+}
+
+// one epoch, iTOW tow ms, the antenna swaying by a few centimetres
+static void epoch(FILE *out, unsigned long n)
+{
+    unsigned long tow = 3600000UL + 1000UL * n;
+    double ecef[3];
+    time_t utc;
+    struct tm tm;
+    unsigned i;
+
+    geo_llh_to_ecef(55.75, 37.62, 150.0 + 0.01 * (double)(n % 7), ecef);
+
+    memset(payload, 0, 8 + 12 * ALLOC_TEST_SATS);
+    put4(0, tow);
+    put2(8, ALLOC_TEST_WEEK);
+    payload[10] = 3;                    // 3D fix
+    payload[11] = 0x0d;                 // gpsFixOK, WKNSET, TOWSET
+    put4(12, (unsigned long)(long)(ecef[0] * 100.0));
+    put4(16, (unsigned long)(long)(ecef[1] * 100.0));
+    put4(20, (unsigned long)(long)(ecef[2] * 100.0));
+    put4(24, 150);                      // pAcc, cm
+    put4(40, 10);                       // sAcc, cm/s
+    put2(44, 120);                      // pDOP
+    payload[47] = ALLOC_TEST_SATS;
+    frame(out, 0x01, 0x06, 52);
+
+    memset(payload, 0, 8 + 12 * ALLOC_TEST_SATS);
+    put4(0, tow);
+    put2(4, 180);                       // gDOP .. eDOP
+    put2(6, 150);
+    put2(8, 90);
+    put2(10, 120);
+    put2(12, 80);
+    put2(14, 60);
+    put2(16, 50);
+    frame(out, 0x01, 0x04, 18);
+
+    memset(payload, 0, 8 + 12 * ALLOC_TEST_SATS);
+    put4(0, tow);
+    payload[4] = 1;                     // version
+    payload[5] = ALLOC_TEST_SATS;
+    for (i = 0; i < ALLOC_TEST_SATS; i++) {
+        size_t off = 8 + 12 * i;
+
+        payload[off] = (unsigned char)(i % 3 * 3);     // GPS, BeiDou, GLONASS
+        payload[off + 1] = (unsigned char)(i + 1);
+        payload[off + 2] = (unsigned char)(30 + i % 15);
+        payload[off + 3] = (unsigned char)(5 + (i * 7 + n / 120) % 80);
+        put2(off + 4, (unsigned)((i * 15 + n / 60) % 360));
+        put4(off + 8, 0x0100 | 0x10 | 0x08 | 0x07);    // orbit, healthy, used
+    }
+    frame(out, 0x01, 0x35, 8 + 12 * ALLOC_TEST_SATS);
+
+    utc = 315964800 + (time_t)ALLOC_TEST_WEEK * 604800 +
+          (time_t)(tow / 1000) - ALLOC_TEST_LEAP;
+    (void)gmtime_r(&utc, &tm);
+    memset(payload, 0, 8 + 12 * ALLOC_TEST_SATS);
+    put4(0, tow);
+    put4(4, 20);                        // tAcc, ns
+    put2(12, (unsigned)(tm.tm_year + 1900));
+    payload[14] = (unsigned char)(tm.tm_mon + 1);
+    payload[15] = (unsigned char)tm.tm_mday;
+    payload[16] = (unsigned char)tm.tm_hour;
+    payload[17] = (unsigned char)tm.tm_min;
+    payload[18] = (unsigned char)tm.tm_sec;
+    payload[19] = 0x07;                 // validTOW, validWKN, validUTC
+    frame(out, 0x01, 0x21, 20);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long epochs = ALLOC_TEST_EPOCHS, n;
+    FILE *stream = tmpfile();
+    int null = open("/dev/null", O_WRONLY);
+    int status;
+
+    if (1 < argc) {
+        epochs = strtoul(argv[1], NULL, 10);
+    }
+    if (2 < argc &&
+        !pgsink_open(argv[2], "alloc_test")) {
+        return EXIT_FAILURE;
+    }
+    if (NULL == stream ||
+        0 > null) {
+        (void)fputs("alloc_test: no temporary file\n", stderr);
+        return EXIT_FAILURE;
+    }
+    for (n = 0; n < epochs; n++) {
+        epoch(stream, n);
+    }
+    // the replay reads the stream on stdin and writes its lines nowhere
+    if (0 != fflush(stream) ||
+        0 > lseek(fileno(stream), 0, SEEK_SET) ||
+        0 > dup2(fileno(stream), STDIN_FILENO) ||
+        0 > dup2(null, STDOUT_FILENO)) {
+        (void)fputs("alloc_test: can't set up the replay\n", stderr);
+        return EXIT_FAILURE;
+    }
+    verbosity = VERB_FIX;
+    status = gpsmon_replay("-");
+    (void)fprintf(stderr, "alloc_test: %lu heap calls by libpq for the "
+                  "COPY batches\n",
+                  atomic_load_explicit(&libpq_calls, memory_order_relaxed));
+    return status;
+}
+
+// vim: set expandtab shiftwidth=4
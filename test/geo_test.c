@@ -0,0 +1,175 @@
+/*
+ * Accuracy test and benchmark of geo.c against libgpsd.
+ *
+ * Random points, latitude -90..90, longitude -180..180, height
+ * -500 m..GEO_TEST_HMAX, are put into ECEF with geo_llh_to_ecef() and
+ * converted back by geo_ecef_to_llh() and by ecef_to_wgs84fix().  The
+ * generated point is the truth: both errors are reported, and
+ * geo_ecef_to_llh() must stay within GEO_TEST_TOL of it and of the
+ * libgpsd result within GEO_TEST_AGREE.  Then both converters, the
+ * batch entry point and the ENU batch are timed.
+ *
+ * Exit status 0 when within tolerance.  Optional argument: number of
+ * points.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "include/gpsd.h"
+#include "include/geo.h"
+
+#define GEO_TEST_N      1000000
+#define GEO_TEST_HMAX   100000.0        // m, up to low orbit
+#define GEO_TEST_TOL    1e-6            // m, against the truth
+#define GEO_TEST_AGREE  0.01            // m, against ecef_to_wgs84fix()
+
+static double *x, *y, *z, *lat, *lon, *h, *tlat, *tlon, *th;
+
+// reproducible uniform in [lo, hi)
+static double uniform(double lo, double hi)
+{
+    static unsigned long long state = 0x853c49e6748fea9bULL;
+
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return lo + (hi - lo) * (double)(state >> 11) / 9007199254740992.0;
+}
+
+// horizontal and vertical distance of a result from the truth, m
+static void error_m(size_t i, double la, double lo, double hh,
+                    double *hor, double *ver)
+{
+    double dlon = remainder(lo - tlon[i], 360.0);
+    double north = (la - tlat[i]) * DEG_2_RAD * WGS84A;
+    double east = dlon * DEG_2_RAD * WGS84A * cos(tlat[i] * DEG_2_RAD);
+
+    *hor = sqrt(north * north + east * east);
+    *ver = fabs(hh - th[i]);
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = GEO_TEST_N, i;
+    double geo_hor = 0, geo_ver = 0, gpsd_hor = 0, gpsd_ver = 0;
+    double agree = 0, t0, sink = 0;
+    struct geo_enu_t enu;
+    struct gps_fix_t fix;
+    double *e, *nn, *u;
+
+    if (1 < argc) {
+        n = (size_t)strtoul(argv[1], NULL, 10);
+    }
+    x = malloc(n * sizeof(double) * 12);
+    if (NULL == x ||
+        0 == n) {
+        (void)fputs("geo_test: no memory\n", stderr);
+        return EXIT_FAILURE;
+    }
+    y = x + n;
+    z = y + n;
+    lat = z + n;
+    lon = lat + n;
+    h = lon + n;
+    tlat = h + n;
+    tlon = tlat + n;
+    th = tlon + n;
+    e = th + n;
+    nn = e + n;
+    u = nn + n;
+
+    for (i = 0; i < n; i++) {
+        double ecef[3];
+
+        tlat[i] = uniform(-90.0, 90.0);
+        tlon[i] = uniform(-180.0, 180.0);
+        th[i] = uniform(-500.0, GEO_TEST_HMAX);
+        geo_llh_to_ecef(tlat[i], tlon[i], th[i], ecef);
+        x[i] = ecef[0];
+        y[i] = ecef[1];
+        z[i] = ecef[2];
+    }
+
+    // accuracy
+    for (i = 0; i < n; i++) {
+        double hor, ver;
+
+        geo_ecef_to_llh(x[i], y[i], z[i], &lat[i], &lon[i], &h[i]);
+        error_m(i, lat[i], lon[i], h[i], &hor, &ver);
+        geo_hor = fmax(geo_hor, hor);
+        geo_ver = fmax(geo_ver, ver);
+
+        (void)ecef_to_wgs84fix(&fix, x[i], y[i], z[i], 0.0, 0.0, 0.0);
+        error_m(i, fix.latitude, fix.longitude, fix.altHAE, &hor, &ver);
+        gpsd_hor = fmax(gpsd_hor, hor);
+        gpsd_ver = fmax(gpsd_ver, ver);
+
+        // the same distance, between the two results
+        tlat[i] = lat[i];
+        tlon[i] = lon[i];
+        th[i] = h[i];
+        error_m(i, fix.latitude, fix.longitude, fix.altHAE, &hor, &ver);
+        agree = fmax(agree, fmax(hor, ver));
+    }
+    (void)printf("max error, m          horizontal  vertical\n");
+    (void)printf("geo_ecef_to_llh()     %10.3g  %10.3g\n", geo_hor, geo_ver);
+    (void)printf("ecef_to_wgs84fix()    %10.3g  %10.3g\n", gpsd_hor, gpsd_ver);
+    (void)printf("largest difference    %10.3g m\n", agree);
+
+    // speed
+    t0 = now_ns();
+    for (i = 0; i < n; i++) {
+        geo_ecef_to_llh(x[i], y[i], z[i], &lat[i], &lon[i], &h[i]);
+    }
+    (void)printf("geo_ecef_to_llh()     %8.1f ns/point\n",
+                 (now_ns() - t0) / (double)n);
+    t0 = now_ns();
+    geo_ecef_to_llh_n(x, y, z, lat, lon, h, n);
+    (void)printf("geo_ecef_to_llh_n()   %8.1f ns/point\n",
+                 (now_ns() - t0) / (double)n);
+    t0 = now_ns();
+    for (i = 0; i < n; i++) {
+        (void)ecef_to_wgs84fix(&fix, x[i], y[i], z[i], 0.0, 0.0, 0.0);
+        sink += fix.latitude;
+    }
+    (void)printf("ecef_to_wgs84fix()    %8.1f ns/point\n",
+                 (now_ns() - t0) / (double)n);
+    geo_enu_init(&enu, 55.75, 37.62, 150.0);
+    t0 = now_ns();
+    geo_enu_n(&enu, x, y, z, e, nn, u, n);
+    (void)printf("geo_enu_n()           %8.1f ns/point\n",
+                 (now_ns() - t0) / (double)n);
+    for (i = 0; i < n; i++) {
+        sink += lat[i] + e[i] + nn[i] + u[i];
+    }
+    if (isnan(sink)) {
+        (void)puts("NaN in the results");
+        return EXIT_FAILURE;
+    }
+
+    free(x);
+    if (GEO_TEST_TOL < geo_hor ||
+        GEO_TEST_TOL < geo_ver ||
+        GEO_TEST_AGREE < agree) {
+        (void)puts("FAIL");
+        return EXIT_FAILURE;
+    }
+    (void)puts("OK");
+    return EXIT_SUCCESS;
+}
+
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,159 @@
+/*
+ * Test of lb_fixed() against snprintf("%W.Pf").
+ *
+ * lb_fixed() claims the same bytes as glibc for precisions 0..9.  Every
+ * value is formatted both ways, with the widths and precisions of the
+ * console line (print_nav_sol() and the NAV-DOP column) and with every
+ * precision 0..9 at width 0, with and without the plus flag:
+ *   - random values over all magnitudes up to 1e10, both signs;
+ *   - exact decimal ties, (2k+1) / 2^(P+1), which round half to even;
+ *   - the values around +-1e9, where lb_fixed() hands over to snprintf();
+ *   - zeroes, subnormals, infinities and NaN.
+ *
+ * Exit status 0 when all agree; the first differences are printed.
+ * Optional argument: number of random values.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/linebuf.h"
+
+#define LINEBUF_TEST_N      200000
+#define LINEBUF_TEST_SHOW   10          // differences printed
+
+static const struct {
+    int width, prec;
+    bool plus;
+} formats[] = {
+    // the console line
+    {5, 1, false},
+    {6, 2, false},
+    {7, 2, false},
+    {8, 2, false},
+    {10, 3, false},
+    {12, 9, false},
+    {13, 9, false},
+    {8, 3, true},
+    {9, 2, true},
+    {10, 2, true},
+    // every precision
+    {0, 0, false}, {0, 1, false}, {0, 2, false}, {0, 3, false},
+    {0, 4, false}, {0, 5, false}, {0, 6, false}, {0, 7, false},
+    {0, 8, false}, {0, 9, false},
+    {0, 0, true}, {0, 1, true}, {0, 2, true}, {0, 3, true},
+    {0, 4, true}, {0, 5, true}, {0, 6, true}, {0, 7, true},
+    {0, 8, true}, {0, 9, true},
+};
+#define NFORMATS    (sizeof(formats) / sizeof(formats[0]))
+
+static unsigned long checked, failed;
+
+// reproducible uniform in [0, 1)
+static double uniform(void)
+{
+    static unsigned long long state = 0x853c49e6748fea9bULL;
+
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (double)(state >> 11) / 9007199254740992.0;
+}
+
+// v in one format both ways
+static void check(double v, unsigned f)
+{
+    struct linebuf_t lb;
+    char want[LINEBUF_LEN];
+
+    lb_reset(&lb);
+    lb_fixed(&lb, v, formats[f].width, formats[f].prec, formats[f].plus);
+    (void)snprintf(want, sizeof(want), formats[f].plus ? "%+*.*f" : "%*.*f",
+                   formats[f].width, formats[f].prec, v);
+    checked++;
+    if (strlen(want) == lb.len &&
+        0 == memcmp(want, lb.buf, lb.len)) {
+        return;
+    }
+    if (LINEBUF_TEST_SHOW > failed++) {
+        (void)printf("%.17g %%%s%d.%df: \"%s\", lb_fixed \"%.*s\"\n", v,
+                     formats[f].plus ? "+" : "", formats[f].width,
+                     formats[f].prec, want, (int)lb.len, lb.buf);
+    }
+}
+
+static void check_all(double v)
+{
+    unsigned f;
+
+    for (f = 0; f < NFORMATS; f++) {
+        check(v, f);
+        check(-v, f);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const double special[] = {
+        0.0, DBL_MIN, DBL_TRUE_MIN, 5e-324 * 3, 1e-10, 0.5, 1.0, 9.5,
+        99.95, 999999999.5, 999999999.9999999, 1e9, 1e10, 1234567890.125,
+        INFINITY, NAN,
+    };
+    unsigned long n = LINEBUF_TEST_N, i;
+    unsigned p, k;
+
+    if (1 < argc) {
+        n = strtoul(argv[1], NULL, 10);
+    }
+
+    for (i = 0; i < sizeof(special) / sizeof(special[0]); i++) {
+        check_all(special[i]);
+    }
+
+    // the hand-over to snprintf() at 1e9
+    {
+        double v = 1e9;
+
+        for (i = 0; i < 64; i++) {
+            v = nextafter(v, 0.0);
+        }
+        for (i = 0; i < 128; i++) {
+            check_all(v);
+            v = nextafter(v, INFINITY);
+        }
+    }
+
+    // exact ties at each precision, small and large
+    for (p = 0; p <= 9; p++) {
+        double scale = ldexp(1.0, -(int)(p + 1));
+
+        for (k = 0; k < 20000; k++) {
+            check_all((2.0 * k + 1.0) * scale);
+            // below 1e9, inside the exact path
+            check_all((2.0 * floor(uniform() * ldexp(1e9, (int)p)) + 1.0) *
+                      scale);
+        }
+    }
+
+    // random magnitudes from 1e-12 to 1e10
+    for (i = 0; i < n; i++) {
+        check_all(pow(10.0, -12.0 + 22.0 * uniform()) * uniform());
+    }
+
+    (void)printf("%lu comparisons, %lu differences\n", checked, failed);
+    if (0 != failed) {
+        (void)puts("FAIL");
+        return EXIT_FAILURE;
+    }
+    (void)puts("OK");
+    return EXIT_SUCCESS;
+}
+
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,135 @@
+/*
+ * Time transfer logging: TIM-TP pulses against the kernel PPS, and
+ * TIM-TM2 external events.
+ *
+ * TIM-TP announces the next time pulse: its nominal time and qErr, the
+ * quantization error by which the receiver's clock tick will miss it
+ * (actual minus nominal, ps).  It arrives after the previous pulse, so
+ * when the following TIM-TP comes in, the last edge seen by the pps
+ * thread later than the first one's arrival is the pulse it announced.
+ * Each such pair is one row: the host clock at the edge, its offset
+ * from the nominal time, and the offset with qErr taken out, which
+ * removes the sawtooth of the pulse generator.
+ *
+ * TIM-TM2 rows carry the rising and falling edge of an EXTINT event as
+ * the receiver timed them.  timestamptz keeps microseconds, the ns
+ * below that go to their own column.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "include/gpsd.h"
+#include "include/gpsmon.h"
+
+#include "include/pgsink.h"
+#include "include/timing.h"
+
+#define PPS_COLUMNS "\"Серия\", \"Импульс\", \"PPS\", \"Смещение\", " \
+                    "\"qErr\", \"Без пилы\""
+#define PPS_FIELDS  6
+#define TM2_COLUMNS "\"Серия\", \"Канал\", \"Счёт\", \"Фронт\", " \
+                    "\"Фронт, нс\", \"Спад\", \"Спад, нс\", \"Точность\""
+#define TM2_FIELDS  8
+
+static struct pgcopy_t *ppscopy, *tm2copy;
+
+// the pulse announced by the last TIM-TP
+static struct {
+    bool valid;
+    struct timespec pulse;      // nominal, UTC
+    long qerr;                  // ps
+    bool qerr_ok;
+    struct timespec rx;         // host clock at the TIM-TP
+} next;
+
+static void copy_pulse(const struct timespec *edge)
+{
+    // host minus nominal, ns; both are near each other, no overflow
+    double offset = (double)(edge->tv_sec - next.pulse.tv_sec) * 1e9 +
+                    (double)(edge->tv_nsec - next.pulse.tv_nsec);
+
+    pgcopy_row(ppscopy, PPS_FIELDS);
+    pgcopy_int4(ppscopy, pgsink_series_id());
+    pgcopy_timespec(ppscopy, &next.pulse);
+    pgcopy_timespec(ppscopy, edge);
+    pgcopy_float8(ppscopy, offset);
+    if (next.qerr_ok) {
+        pgcopy_int4(ppscopy, next.qerr);
+        // the edge was qErr late, the host clock that much less ahead
+        pgcopy_float8(ppscopy, offset - (double)next.qerr / 1000.0);
+    } else {
+        pgcopy_null(ppscopy);
+        pgcopy_null(ppscopy);
+    }
+    pgcopy_commit(ppscopy);
+}
+
+// one TIM-TP: nominal time of the next pulse, its qErr, arrival time
+void timing_tp(const struct timespec *pulse, long qerr_ps, bool qerr_ok,
+               const struct timespec *rx)
+{
+    struct timedelta_t pps;
+
+    if (NULL == ppscopy &&
+        pgsink_active()) {
+        ppscopy = pgsink_stream("Измерения", "U-Blox-PPS", PPS_COLUMNS,
+                                false);
+    }
+    if (NULL != ppscopy &&
+        next.valid &&
+        serial &&
+        0 < pps_thread_ppsout(&session.pps_thread, &pps) &&
+        // the edge must fall between the two TIM-TPs
+        TS_GT(&pps.clock, &next.rx) &&
+        TS_GT(rx, &pps.clock)) {
+        copy_pulse(&pps.clock);
+    }
+    next.pulse = *pulse;
+    next.qerr = qerr_ps;
+    next.qerr_ok = qerr_ok;
+    next.rx = *rx;
+    next.valid = 0 != rx->tv_sec;
+}
+
+static void copy_edge(const struct timespec *ts)
+{
+    if (NULL == ts) {
+        pgcopy_null(tm2copy);
+        pgcopy_null(tm2copy);
+        return;
+    }
+    pgcopy_timespec(tm2copy, ts);
+    pgcopy_int2(tm2copy, (int)(ts->tv_nsec % 1000));
+}
+
+/* one TIM-TM2 with at least one new edge; rise or fall is NULL when
+ * that edge is not new */
+void timing_tm2(unsigned ch, unsigned count, const struct timespec *rise,
+                const struct timespec *fall, unsigned long acc_ns)
+{
+    if (NULL == tm2copy &&
+        pgsink_active()) {
+        tm2copy = pgsink_stream("Измерения", "U-Blox-события",
+                                TM2_COLUMNS, false);
+    }
+    if (NULL == tm2copy) {
+        return;
+    }
+    pgcopy_row(tm2copy, TM2_FIELDS);
+    pgcopy_int4(tm2copy, pgsink_series_id());
+    pgcopy_int2(tm2copy, (int)ch);
+    pgcopy_int4(tm2copy, (long)count);
+    copy_edge(rise);
+    copy_edge(fall);
+    pgcopy_int4(tm2copy, (long)acc_ns);
+    pgcopy_commit(tm2copy);
+}
+
+// vim: set expandtab shiftwidth=4
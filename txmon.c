@@ -0,0 +1,154 @@
+/*
+ * Receiver TX buffer polling and overload diagnosis.
+ *
+ * A u-blox receiver that cannot send its output fast enough drops it
+ * from its TX buffer without a word; on our side that is just a missing
+ * epoch.  With -o the receiver is polled for MON-TXBUF (u-blox 8) and
+ * MON-COMMS (u-blox 9 and later) every few seconds.  At each poll the
+ * peak TX buffer usage and drop flags it reported since the last one
+ * are set against our own counters, and the first that applies names
+ * the bottleneck:
+ *
+ *   database  rows were lost, or too many wait for the database.
+ *             Flushes run in the main loop, so a slow database also
+ *             stalls reading; it has to be ruled out first.
+ *   parser    the tty holds more unread bytes than one burst.
+ *   link      we keep up, yet the receiver reports a full TX buffer, or
+ *             frames arrive corrupted.
+ *
+ * A change of verdict is reported once; M_OVERLOAD always holds it.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <time.h>
+
+#include "include/gpsd.h"
+#include "include/gpsmon.h"
+
+#include "include/driver_ubx.h"
+#include "include/metrics.h"
+#include "include/txmon.h"
+
+static const char *const verdicts[] = {"none", "link", "parser", "database"};
+
+static struct {
+    int sec;                    // poll period, 0 for none
+    struct timespec due;        // CLOCK_MONOTONIC of the next poll
+    unsigned peak;              // receiver reports since the last poll
+    bool dropped;
+    bool heard;
+    unsigned long badsum, lost; // counters at the last poll
+    int verdict;
+} mon = {0, {0, 0}, 0, false, false, 0, 0, TXMON_NONE};
+
+// -o: poll period in seconds
+bool txmon_config(const char *spec)
+{
+    char *end;
+    long sec = strtol(spec, &end, 10);
+
+    if (end == spec ||
+        '\0' != *end ||
+        1 > sec ||
+        3600 < sec) {
+        return false;
+    }
+    mon.sec = (int)sec;
+    return true;
+}
+
+/* From the MON-TXBUF/MON-COMMS decoders: peak TX buffer usage in %,
+ * and whether the receiver had to drop output. */
+void txmon_receiver(unsigned peak, bool dropped)
+{
+    if (peak > mon.peak) {
+        mon.peak = peak;
+    }
+    mon.dropped |= dropped;
+    mon.heard = true;
+}
+
+/* Our own counters are checked every period; the receiver's report
+ * only adds the link verdict, so a receiver that does not answer (u-blox
+ * 7 NAKs both polls) or a reply delayed by a stalled loop still lets the
+ * database and parser verdicts through. */
+static int txmon_verdict(void)
+{
+    unsigned long badsum = metrics_get(M_BADSUM);
+    unsigned long lost = metrics_get(M_LOST);
+    int backlog = 0;
+    int verdict = TXMON_NONE;
+
+    (void)ioctl(session.gpsdata.gps_fd, FIONREAD, &backlog);
+    if (lost != mon.lost ||
+        TXMON_QUEUED <= metrics_get(M_QUEUED)) {
+        verdict = TXMON_DATABASE;
+    } else if (TXMON_BACKLOG <= backlog) {
+        verdict = TXMON_PARSER;
+    } else if (mon.heard &&
+               (mon.dropped ||
+                TXMON_PEAK <= mon.peak ||
+                badsum != mon.badsum)) {
+        verdict = TXMON_LINK;
+    }
+    mon.badsum = badsum;
+    mon.lost = lost;
+    return verdict;
+}
+
+// from the main loop, at least every two seconds
+void txmon_tick(void)
+{
+    static unsigned char txbuf[2] = {UBX_CLASS_MON, UBX_MON_TXBUF & 0xff};
+    static unsigned char comms[2] = {UBX_CLASS_MON, UBX_MON_COMMS & 0xff};
+    struct timespec now;
+    int verdict;
+
+    if (0 == mon.sec ||
+        !serial) {
+        return;
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec < mon.due.tv_sec) {
+        return;
+    }
+
+    if (0 == mon.due.tv_sec) {
+        // first poll: baseline
+        mon.badsum = metrics_get(M_BADSUM);
+        mon.lost = metrics_get(M_LOST);
+    } else {
+        verdict = txmon_verdict();
+        if (verdict != mon.verdict) {
+            if (mon.heard) {
+                (void)fprintf(stderr, "gpsmon: overload: %s (receiver TX "
+                              "peak %u%%%s)\n", verdicts[verdict], mon.peak,
+                              mon.dropped ? ", output dropped" : "");
+            } else {
+                (void)fprintf(stderr, "gpsmon: overload: %s (no receiver "
+                              "report)\n", verdicts[verdict]);
+            }
+            mon.verdict = verdict;
+            metrics_set(M_OVERLOAD, (unsigned long)verdict);
+        }
+        if (mon.heard) {
+            metrics_set(M_TXPEAK, mon.peak);
+        }
+    }
+    mon.due.tv_sec = now.tv_sec + mon.sec;
+    mon.heard = false;
+    mon.peak = 0;
+    mon.dropped = false;
+    (void)monitor_control_send(txbuf, sizeof(txbuf));
+    (void)monitor_control_send(comms, sizeof(comms));
+}
+
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,236 @@
+/*
+ * Fast framing of a pure UBX byte stream.
+ *
+ * The gpsd lexer feeds every byte through a state machine that knows
+ * two dozen protocols and sums the UBX checksum one byte per state.
+ * For a stream known to carry UBX only, ubx_scan() jumps to the next
+ * sync byte with memchr(), reads the declared length, checks the
+ * whole frame in one pass and hands it over in place, without copying.
+ *
+ * The Fletcher checksum is summed eight bytes per step.  Over a block
+ * b[0..7] A grows by the plain sum and B by 8 * A plus the weighted sum
+ * 8 b[0] + 7 b[1] + ... + b[7], which is what eight single steps give.
+ * The sums are kept in 32 bits and reduced mod 256 at the end.
+ *
+ * ubxlex_feed() is the same framing for a live stream that arrives in
+ * pieces of any size: it keeps just enough state to resume in the
+ * middle of a frame and copies payload in bulk, not byte by byte.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "include/compiler.h"         // for FALLTHROUGH
+#include "include/ubxframe.h"
+
+void ubx_checksum(const unsigned char *p, size_t n,
+                  unsigned char *ck_a, unsigned char *ck_b)
+{
+    uint32_t a = 0, b = 0;
+
+    for (; 8 <= n; n -= 8, p += 8) {
+        b += 8 * a +
+             8 * (uint32_t)p[0] + 7 * (uint32_t)p[1] +
+             6 * (uint32_t)p[2] + 5 * (uint32_t)p[3] +
+             4 * (uint32_t)p[4] + 3 * (uint32_t)p[5] +
+             2 * (uint32_t)p[6] + (uint32_t)p[7];
+        a += (uint32_t)p[0] + p[1] + p[2] + p[3] +
+             p[4] + p[5] + p[6] + p[7];
+    }
+    for (; 0 < n; n--, p++) {
+        a += *p;
+        b += a;
+    }
+    *ck_a = (unsigned char)a;
+    *ck_b = (unsigned char)b;
+}
+
+// frame is a complete UBX frame of len bytes, sync included
+bool ubx_frame_ok(const unsigned char *frame, size_t len)
+{
+    unsigned char ck_a, ck_b;
+
+    if (UBX_HDR_LEN + 2 > len) {
+        return false;
+    }
+    ubx_checksum(frame + 2, len - 4, &ck_a, &ck_b);
+    return ck_a == frame[len - 2] &&
+           ck_b == frame[len - 1];
+}
+
+/* Deliver every complete, valid frame in buf[0..len) to cb.  Returns
+ * the number of bytes consumed; the rest is the start of a frame still
+ * arriving and must be presented again with the bytes that follow. */
+size_t ubx_scan(struct ubxscan_t *st, const unsigned char *buf, size_t len,
+                ubx_frame_cb cb, void *arg)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        const unsigned char *p = memchr(buf + i, UBX_SYNC1, len - i);
+        size_t n;
+
+        if (NULL == p) {
+            st->skipped += len - i;
+            return len;
+        }
+        st->skipped += (size_t)(p - (buf + i));
+        i = (size_t)(p - buf);
+
+        if (1 == len - i) {
+            return i;           // lone sync byte at the end
+        }
+        if (UBX_SYNC2 != buf[i + 1]) {
+            st->skipped++;
+            i++;
+            continue;
+        }
+        if (UBX_HDR_LEN > len - i) {
+            return i;
+        }
+        n = UBX_HDR_LEN + ((size_t)buf[i + 4] | (size_t)buf[i + 5] << 8) + 2;
+        if (UBX_FRAME_MAX < n) {
+            // payload data that happens to look like a sync
+            st->skipped++;
+            i++;
+            continue;
+        }
+        if (n > len - i) {
+            return i;
+        }
+        if (!ubx_frame_ok(buf + i, n)) {
+            // resync right after this sync byte, like the gpsd lexer
+            st->badsum++;
+            st->skipped++;
+            i++;
+            continue;
+        }
+        st->frames++;
+        cb(buf + i, n, arg);
+        i += n;
+    }
+    return i;
+}
+
+void ubxlex_init(struct ubxlex_t *lex, unsigned char *frame)
+{
+    memset(lex, 0, sizeof(*lex));
+    lex->frame = frame;
+    lex->state = UBXLEX_SYNC1;
+}
+
+// pick up again with t bytes of an unfinished frame at lex->frame
+static void ubxlex_resume(struct ubxlex_t *lex, size_t t)
+{
+    lex->have = (unsigned short)t;
+    if (0 == t) {
+        lex->state = UBXLEX_SYNC1;
+    } else if (1 == t) {
+        lex->state = UBXLEX_SYNC2;
+    } else if (UBX_HDR_LEN > t) {
+        lex->state = UBXLEX_HEADER;
+        lex->need = (unsigned short)(UBX_HDR_LEN - t);
+    } else {
+        size_t n = UBX_HDR_LEN + 2 +
+                   ((size_t)lex->frame[4] | (size_t)lex->frame[5] << 8);
+
+        lex->state = UBXLEX_BODY;
+        lex->need = (unsigned short)(n - t);
+    }
+}
+
+/* The frame collected so far started with a false sync.  Rescan what
+ * follows the sync byte for frames, keep any unfinished one. */
+static void ubxlex_resync(struct ubxlex_t *lex, ubx_frame_cb cb, void *arg)
+{
+    size_t rest = (size_t)lex->have - 1;
+    size_t used = ubx_scan(&lex->st, lex->frame + 1, rest, cb, arg);
+
+    lex->st.skipped++;
+    (void)memmove(lex->frame, lex->frame + 1 + used, rest - used);
+    ubxlex_resume(lex, rest - used);
+}
+
+void ubxlex_feed(struct ubxlex_t *lex, const unsigned char *buf, size_t len,
+                 ubx_frame_cb cb, void *arg)
+{
+    while (0 < len) {
+        const unsigned char *p;
+        size_t k;
+
+        switch (lex->state) {
+        case UBXLEX_SYNC1:
+            p = memchr(buf, UBX_SYNC1, len);
+            if (NULL == p) {
+                lex->st.skipped += len;
+                return;
+            }
+            k = (size_t)(p - buf);
+            lex->st.skipped += k;
+            lex->frame[0] = UBX_SYNC1;
+            lex->have = 1;
+            lex->state = UBXLEX_SYNC2;
+            buf += k + 1;
+            len -= k + 1;
+            break;
+        case UBXLEX_SYNC2:
+            if (UBX_SYNC2 != *buf) {
+                // leave the byte, it may be the next 0xb5
+                lex->st.skipped++;
+                lex->state = UBXLEX_SYNC1;
+                break;
+            }
+            lex->frame[1] = UBX_SYNC2;
+            lex->have = 2;
+            lex->need = UBX_HDR_LEN - 2;
+            lex->state = UBXLEX_HEADER;
+            buf++;
+            len--;
+            break;
+        case UBXLEX_HEADER:
+            FALLTHROUGH
+        case UBXLEX_BODY:
+            k = lex->need < len ? lex->need : len;
+            memcpy(lex->frame + lex->have, buf, k);
+            lex->have += (unsigned short)k;
+            lex->need -= (unsigned short)k;
+            buf += k;
+            len -= k;
+            if (0 < lex->need) {
+                break;
+            }
+            if (UBXLEX_HEADER == lex->state) {
+                size_t n = UBX_HDR_LEN + 2 +
+                           ((size_t)lex->frame[4] |
+                            (size_t)lex->frame[5] << 8);
+
+                if (UBX_FRAME_MAX < n) {
+                    ubxlex_resync(lex, cb, arg);
+                } else {
+                    lex->need = (unsigned short)(n - UBX_HDR_LEN);
+                    lex->state = UBXLEX_BODY;
+                }
+            } else if (ubx_frame_ok(lex->frame, lex->have)) {
+                lex->st.frames++;
+                cb(lex->frame, lex->have, arg);
+                lex->have = 0;
+                lex->state = UBXLEX_SYNC1;
+            } else {
+                lex->st.badsum++;
+                ubxlex_resync(lex, cb, arg);
+            }
+            break;
+        default:
+            lex->state = UBXLEX_SYNC1;
+            break;
+        }
+    }
+}
+
+// vim: set expandtab shiftwidth=4
@@ -0,0 +1,218 @@
+/*
+ * UART rate upgrade and UBX-only port setup.
+ *
+ * With -b the receiver's UART 1 is moved to the fastest rate, up to the
+ * given one, at which it answers, and its input and output are limited
+ * to UBX.  Each step sends CFG-PRT, lets it drain at the old rate,
+ * switches the host side with gpsd_set_speed(), then polls CFG-PRT and
+ * waits for the ACK at the new rate.  A rate that is not acknowledged
+ * within UBXLINK_VERIFY_SEC is abandoned for the next lower one; the
+ * last candidate is the rate we started at, so that a failed upgrade
+ * still leaves a working, UBX-only port.  Once a rate holds, the bytes
+ * received over UBXLINK_MEASURE_SEC give the link utilisation.
+ *
+ * This file is Copyright by the GPSD project
+ * SPDX-License-Identifier: BSD-2-clause
+ */
+
+#include "include/gpsd_config.h"  // must be before all includes
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+
+#include "include/gpsd.h"
+#include "include/bits.h"
+#include "include/gpsmon.h"
+
+#include "include/driver_ubx.h"
+#include "include/metrics.h"
+#include "include/ubxlink.h"
+
+#define UBX_PORT_UART1          1
+#define UBX_MODE_8N1            0x000008d0
+#define UBX_PROTO_UBX           0x0001
+
+#define LINK_OFF        0       // no -b
+#define LINK_WANTED     1       // -b given, waiting for the first packet
+#define LINK_VERIFY     2       // switched, waiting for the ACK
+#define LINK_MEASURE    3       // rate holds, counting bytes
+#define LINK_DONE       4
+#define LINK_FAILED     5
+
+// rates tried, fastest first; the one we started at is always last
+static const speed_t rates[] = {921600, 460800, 230400, 115200, 57600,
+                                38400, 19200, 9600};
+#define NRATES  (sizeof(rates) / sizeof(rates[0]))
+
+static struct {
+    int state;
+    speed_t max;                // from -b
+    speed_t orig;               // host rate at start
+    speed_t cur;                // host rate now
+    unsigned next;              // next index into rates[]
+    struct timespec deadline;
+    unsigned long bytes;        // M_BYTES when the measurement started
+} uart = {LINK_OFF, 0, 0, 0, 0, {0, 0}, 0};
+
+// -b: fastest rate to try
+bool ubxlink_config(const char *spec)
+{
+    char *end;
+    unsigned long baud = strtoul(spec, &end, 10);
+    unsigned i;
+
+    if (end == spec ||
+        '\0' != *end) {
+        return false;
+    }
+    for (i = 0; i < NRATES; i++) {
+        if (rates[i] == baud) {
+            uart.max = (speed_t)baud;
+            uart.state = LINK_WANTED;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void deadline_in(int sec)
+{
+    (void)clock_gettime(CLOCK_MONOTONIC, &uart.deadline);
+    uart.deadline.tv_sec += sec;
+}
+
+static bool deadline_passed(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > uart.deadline.tv_sec ||
+           (now.tv_sec == uart.deadline.tv_sec &&
+            now.tv_nsec >= uart.deadline.tv_nsec);
+}
+
+// CFG-PRT for UART 1: rate, 8N1, UBX in and out
+static void send_prt(speed_t rate)
+{
+    unsigned char msg[2 + 20];
+
+    memset(msg, 0, sizeof(msg));
+    msg[0] = UBX_CLASS_CFG;
+    msg[1] = UBX_CFG_PRT & 0xff;
+    msg[2] = UBX_PORT_UART1;
+    putle32(msg, 2 + 4, UBX_MODE_8N1);
+    putle32(msg, 2 + 8, rate);
+    putle16(msg, 2 + 12, UBX_PROTO_UBX);
+    putle16(msg, 2 + 14, UBX_PROTO_UBX);
+    (void)monitor_control_send(msg, sizeof(msg));
+}
+
+// host side to rate, after what was written has left at the old one
+static void host_speed(speed_t rate)
+{
+    struct timespec delay = {0, 50000000L};
+
+    (void)tcdrain(session.gpsdata.gps_fd);
+    (void)nanosleep(&delay, NULL);
+    session.context->readonly = false;
+    gpsd_set_speed(&session, rate, 'N', 1);
+    session.context->readonly = true;
+    // an ACK still queued from the old rate must not verify the new one
+    (void)tcflush(session.gpsdata.gps_fd, TCIFLUSH);
+    uart.cur = rate;
+}
+
+/* Move to rates[next], or back to orig when the list is used up.  The
+ * receiver listens at orig or at the rate last tried, so the command
+ * goes out at both. */
+static void try_next(void)
+{
+    speed_t rate = uart.orig;
+    unsigned char poll[3] = {UBX_CLASS_CFG, UBX_CFG_PRT & 0xff,
+                             UBX_PORT_UART1};
+
+    while (NRATES > uart.next) {
+        speed_t r = rates[uart.next++];
+
+        if (r <= uart.max &&
+            r > uart.orig) {
+            rate = r;
+            break;
+        }
+    }
+
+    send_prt(rate);
+    if (uart.cur != uart.orig) {
+        host_speed(uart.orig);
+        send_prt(rate);
+    }
+    host_speed(rate);
+    (void)monitor_control_send(poll, sizeof(poll));
+    deadline_in(UBXLINK_VERIFY_SEC);
+    uart.state = LINK_VERIFY;
+}
+
+// first UBX packet: the receiver is there and talking
+void ubxlink_start(void)
+{
+    if (LINK_WANTED != uart.state) {
+        return;
+    }
+    if (!serial ||
+        SOURCE_ACM == session.sourcetype) {
+        (void)fputs("gpsmon: no UART to set up, -b ignored\n", stderr);
+        uart.state = LINK_DONE;
+        return;
+    }
+    uart.orig = uart.cur = (speed_t)gpsd_get_speed(&session);
+    uart.next = 0;
+    try_next();
+}
+
+// ACK-ACK or ACK-NAK for msgid
+void ubxlink_ack(unsigned msgid, bool ack)
+{
+    if (LINK_VERIFY != uart.state ||
+        UBX_CFG_PRT != msgid) {
+        return;
+    }
+    if (!ack) {
+        // refused outright, no use waiting
+        uart.deadline.tv_sec = 0;
+        return;
+    }
+    uart.bytes = metrics_get(M_BYTES);
+    deadline_in(UBXLINK_MEASURE_SEC);
+    uart.state = LINK_MEASURE;
+}
+
+// from the main loop, at least every two seconds
+void ubxlink_tick(void)
+{
+    if ((LINK_VERIFY != uart.state &&
+         LINK_MEASURE != uart.state) ||
+        !deadline_passed()) {
+        return;
+    }
+    if (LINK_MEASURE == uart.state) {
+        // 8N1: ten bits on the wire per byte
+        double used = (double)(metrics_get(M_BYTES) - uart.bytes) * 10.0 /
+                      ((double)uart.cur * UBXLINK_MEASURE_SEC);
+
+        (void)fprintf(stderr, "gpsmon: UART at %u baud, UBX only, "
+                      "%.1f%% used\n", (unsigned)uart.cur, used * 100.0);
+        uart.state = LINK_DONE;
+    } else if (uart.cur == uart.orig) {
+        (void)fprintf(stderr, "gpsmon: no ACK for CFG-PRT at any rate, "
+                      "staying at %u baud\n", (unsigned)uart.orig);
+        uart.state = LINK_FAILED;
+    } else {
+        try_next();
+    }
+}
+
+// vim: set expandtab shiftwidth=4